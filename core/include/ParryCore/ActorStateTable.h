@@ -0,0 +1,337 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+/*Per-actor combat state tracked by EldenParry.*/
+struct ActorState
+{
+	enum Flag : std::uint32_t
+	{
+		kNone = 0,
+		kTimingParry = 1 << 0,    // parryStart is valid.
+		kParryCostCached = 1 << 1,  // parryCost holds the stamina cost of the current bash.
+		kParrySucceeded = 1 << 2,   // the current bash parried something; its cost is waived.
+		kScoreCached = 1 << 3,      // staticScore is valid.
+	};
+
+	double        parryStart{ 0.0 };
+	float         parryCost{ 0.0f };
+	std::uint32_t flags{ kNone };
+	float         staticScore{ 0.0f };  // riposte score without the per-attack terms.
+
+	bool has(Flag a_flag) const { return (flags & a_flag) != 0; }
+	void set(Flag a_flag) { flags |= a_flag; }
+	void clear(Flag a_flag) { flags &= ~static_cast<std::uint32_t>(a_flag); }
+};
+
+/*Fixed-capacity, handle-keyed table holding one ActorState per actor.
+Readers (collision hooks, which may run on havok worker threads) never block: every slot is guarded by
+a sequence counter and a reader retries the slot if it observed a write in progress.
+Writers (anim event sink, stamina hook, score cache, actor events) are serialized among themselves and never allocate.
+A record is dropped as soon as it holds no state. Records that only hold an expired parry window or a cached
+score are not swept; their slots are reclaimed by later insertions, so scores cached for every actor ever queried
+can't crowd out parry windows.*/
+class ActorStateTable
+{
+public:
+	using Key = std::uint32_t;
+
+	static constexpr std::size_t CAPACITY = 256;
+
+	/// <summary>
+	/// Look up the state of an actor without taking any lock.
+	/// </summary>
+	/// <param name="a_key">Native handle of the actor.</param>
+	/// <param name="a_stateOut">Receives a copy of the state if the actor is found.</param>
+	/// <returns>True if the actor is in the table.</returns>
+	bool find(Key a_key, ActorState& a_stateOut) const
+	{
+		if (a_key == EMPTY || a_key == TOMBSTONE || _size.load(std::memory_order_acquire) == 0) {
+			return false;
+		}
+		for (std::size_t i = 0, idx = home(a_key); i < CAPACITY; ++i, idx = (idx + 1) & MASK) {
+			Key        key;
+			ActorState state;
+			readSlot(_slots[idx], key, state);
+			if (key == EMPTY) {
+				return false;
+			}
+			if (key == a_key) {
+				a_stateOut = state;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/// <summary>
+	/// Read-modify-write the state of an actor with a single lookup, inserting a blank record if needed.
+	/// The record is removed if a_fn leaves it without any flag.
+	/// </summary>
+	/// <param name="a_fn">Called with the mutable state, under the writer lock. Keep it short.
+	/// Not called at all if the record could not be stored, so side effects in it only happen for stored states.</param>
+	/// <param name="a_expiredBefore">Parry windows started before this time are expired; their slots may be reclaimed.</param>
+	/// <returns>False if the actor was not in the table and the table is full: the modification is lost.</returns>
+	template <class Fn>
+	bool modify(Key a_key, Fn&& a_fn, double a_expiredBefore)
+	{
+		if (a_key == EMPTY || a_key == TOMBSTONE) {
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(_writeLock);
+		Slot* freeSlot = nullptr;
+		bool  reusesExpired = false;
+		for (std::size_t i = 0, idx = home(a_key); i < CAPACITY; ++i, idx = (idx + 1) & MASK) {
+			auto& slot = _slots[idx];
+			auto  key = slot.key.load(std::memory_order_relaxed);
+			if (key == a_key) {
+				ActorState after = loadSlot(slot);
+				a_fn(after);
+				if (after.flags == ActorState::kNone) {
+					eraseSlot(slot);
+				} else {
+					writeSlot(slot, a_key, after);
+				}
+				return true;
+			}
+			if (key == EMPTY) {
+				if (!freeSlot) {
+					freeSlot = std::addressof(slot);
+				}
+				break;
+			}
+			if (!freeSlot) {
+				if (key == TOMBSTONE) {
+					freeSlot = std::addressof(slot);
+				} else if (isExpired(loadSlot(slot), a_expiredBefore)) {
+					freeSlot = std::addressof(slot);
+					reusesExpired = true;
+				}
+			}
+		}
+		if (!freeSlot) {
+			return false;
+		}
+		ActorState after;
+		a_fn(after);
+		if (after.flags == ActorState::kNone) {
+			return true;
+		}
+		writeSlot(*freeSlot, a_key, after);
+		if (!reusesExpired) {
+			_size.fetch_add(1, std::memory_order_release);
+		}
+		return true;
+	}
+
+	void erase(Key a_key)
+	{
+		std::lock_guard<std::mutex> lock(_writeLock);
+		for (std::size_t i = 0, idx = home(a_key); i < CAPACITY; ++i, idx = (idx + 1) & MASK) {
+			auto& slot = _slots[idx];
+			auto  key = slot.key.load(std::memory_order_relaxed);
+			if (key == EMPTY) {
+				return;
+			}
+			if (key == a_key) {
+				eraseSlot(slot);
+				return;
+			}
+		}
+	}
+
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(_writeLock);
+		for (auto& slot : _slots) {
+			if (slot.key.load(std::memory_order_relaxed) != EMPTY) {
+				writeSlot(slot, EMPTY, {});
+			}
+		}
+		_size.store(0, std::memory_order_release);
+	}
+
+	/*Clear a flag in every record, dropping records left without any.*/
+	void clearFlag(ActorState::Flag a_flag)
+	{
+		std::lock_guard<std::mutex> lock(_writeLock);
+		for (auto& slot : _slots) {
+			auto key = slot.key.load(std::memory_order_relaxed);
+			if (key == EMPTY || key == TOMBSTONE) {
+				continue;
+			}
+			auto state = loadSlot(slot);
+			if (!state.has(a_flag)) {
+				continue;
+			}
+			state.clear(a_flag);
+			if (state.flags == ActorState::kNone) {
+				eraseSlot(slot);
+			} else {
+				writeSlot(slot, key, state);
+			}
+		}
+	}
+
+	/*Stop timing the parry windows started before a_expiredBefore, dropping records left without any flag.
+	A bash that ends without bashStop (stagger, death) never closes its window otherwise. Takes the writer lock only
+	while some record is timing a parry.*/
+	void clearExpired(double a_expiredBefore)
+	{
+		if (timingCount() == 0) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(_writeLock);
+		for (auto& slot : _slots) {
+			if ((slot.flags.load(std::memory_order_relaxed) & ActorState::kTimingParry) == 0 ||
+				slot.parryStart.load(std::memory_order_relaxed) >= a_expiredBefore) {
+				continue;
+			}
+			auto key = slot.key.load(std::memory_order_relaxed);
+			if (key == EMPTY || key == TOMBSTONE) {
+				continue;
+			}
+			auto state = loadSlot(slot);
+			state.clear(ActorState::kTimingParry);
+			if (state.flags == ActorState::kNone) {
+				eraseSlot(slot);
+			} else {
+				writeSlot(slot, key, state);
+			}
+		}
+	}
+
+	/*Call a_fn(key, state) for every record timing a parry, without taking any lock.*/
+	template <class Fn>
+	void forEachTiming(Fn&& a_fn) const
+	{
+		if (timingCount() == 0) {
+			return;
+		}
+		for (const auto& slot : _slots) {
+			if ((slot.flags.load(std::memory_order_relaxed) & ActorState::kTimingParry) == 0) {
+				continue;
+			}
+			Key        key;
+			ActorState state;
+			readSlot(slot, key, state);
+			if (key != EMPTY && key != TOMBSTONE && state.has(ActorState::kTimingParry)) {
+				a_fn(key, state);
+			}
+		}
+	}
+
+	bool empty() const
+	{
+		return _size.load(std::memory_order_acquire) == 0;
+	}
+
+	/*Number of records currently timing a parry, i.e. actors in a bash. Includes windows that expired since the last clearExpired().*/
+	std::uint32_t timingCount() const
+	{
+		return _timingCount.load(std::memory_order_acquire);
+	}
+
+	/// <summary>
+	/// Check whether a record would be reclaimed at a_expiredBefore: it holds nothing but a stale parry window
+	/// and/or a cached score. A cached score can always be recomputed, so it never keeps a slot on its own.
+	/// </summary>
+	static bool isExpired(const ActorState& a_state, double a_expiredBefore)
+	{
+		const auto flags = a_state.flags & ~static_cast<std::uint32_t>(ActorState::kScoreCached);
+		return flags == ActorState::kNone || (flags == ActorState::kTimingParry && a_state.parryStart < a_expiredBefore);
+	}
+
+private:
+	static constexpr Key         EMPTY = 0;
+	static constexpr Key         TOMBSTONE = 0xFFFFFFFF;
+	static constexpr std::size_t MASK = CAPACITY - 1;
+	static_assert((CAPACITY & MASK) == 0, "capacity must be a power of two");
+
+	struct alignas(32) Slot
+	{
+		std::atomic<std::uint32_t> seq{ 0 };
+		std::atomic<Key>           key{ EMPTY };
+		std::atomic<double>        parryStart{ 0.0 };
+		std::atomic<float>         parryCost{ 0.0f };
+		std::atomic<std::uint32_t> flags{ ActorState::kNone };
+		std::atomic<float>         staticScore{ 0.0f };
+	};
+
+	static std::size_t home(Key a_key)
+	{
+		return static_cast<std::size_t>(a_key * 0x9E3779B1u) & MASK;
+	}
+
+	// Writer-side read, only valid under _writeLock.
+	static ActorState loadSlot(const Slot& a_slot)
+	{
+		ActorState state;
+		state.parryStart = a_slot.parryStart.load(std::memory_order_relaxed);
+		state.parryCost = a_slot.parryCost.load(std::memory_order_relaxed);
+		state.flags = a_slot.flags.load(std::memory_order_relaxed);
+		state.staticScore = a_slot.staticScore.load(std::memory_order_relaxed);
+		return state;
+	}
+
+	static void readSlot(const Slot& a_slot, Key& a_key, ActorState& a_state)
+	{
+		while (true) {
+			auto seq = a_slot.seq.load(std::memory_order_acquire);
+			if (seq & 1) {
+				std::this_thread::yield();
+				continue;
+			}
+			a_key = a_slot.key.load(std::memory_order_relaxed);
+			a_state = loadSlot(a_slot);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (a_slot.seq.load(std::memory_order_relaxed) == seq) {
+				return;
+			}
+		}
+	}
+
+	void writeSlot(Slot& a_slot, Key a_key, const ActorState& a_state)
+	{
+		const bool wasTiming = (a_slot.flags.load(std::memory_order_relaxed) & ActorState::kTimingParry) != 0;
+		const bool isTiming = (a_state.flags & ActorState::kTimingParry) != 0;
+		if (isTiming && !wasTiming) {
+			_timingCount.fetch_add(1, std::memory_order_release);
+		}
+
+		auto seq = a_slot.seq.load(std::memory_order_relaxed);
+		a_slot.seq.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		a_slot.key.store(a_key, std::memory_order_relaxed);
+		a_slot.parryStart.store(a_state.parryStart, std::memory_order_relaxed);
+		a_slot.parryCost.store(a_state.parryCost, std::memory_order_relaxed);
+		a_slot.flags.store(a_state.flags, std::memory_order_relaxed);
+		a_slot.staticScore.store(a_state.staticScore, std::memory_order_relaxed);
+		a_slot.seq.store(seq + 2, std::memory_order_release);
+
+		if (wasTiming && !isTiming) {
+			_timingCount.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	void eraseSlot(Slot& a_slot)
+	{
+		writeSlot(a_slot, TOMBSTONE, {});
+		if (_size.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			// table is empty: clear tombstones so probe chains stay short.
+			for (auto& slot : _slots) {
+				if (slot.key.load(std::memory_order_relaxed) == TOMBSTONE) {
+					writeSlot(slot, EMPTY, {});
+				}
+			}
+		}
+	}
+
+	std::array<Slot, CAPACITY> _slots;
+	std::atomic<std::size_t>   _size{ 0 };
+	std::atomic<std::uint32_t> _timingCount{ 0 };
+	std::mutex                 _writeLock;
+};
@@ -0,0 +1,71 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*Bounded, lock-free multi-producer single-consumer queue.
+Pushing never blocks: when the queue is full the push fails and the caller decides what to drop.*/
+template <class T, std::size_t N>
+class MPSCQueue
+{
+public:
+	static constexpr std::size_t CAPACITY = N;
+
+	MPSCQueue()
+	{
+		for (std::size_t i = 0; i < CAPACITY; ++i) {
+			_cells[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	/*Enqueue an item. Any thread.
+	@return false if the queue was full.*/
+	bool push(const T& a_item)
+	{
+		auto pos = _tail.load(std::memory_order_relaxed);
+		while (true) {
+			auto& cell = _cells[pos & MASK];
+			auto  seq = cell.seq.load(std::memory_order_acquire);
+			auto  diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+			if (diff == 0) {
+				if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					cell.item = a_item;
+					cell.seq.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = _tail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/*Dequeue an item. Consumer thread only.
+	@return false if the queue is empty.*/
+	bool pop(T& a_item)
+	{
+		auto& cell = _cells[_head & MASK];
+		if (cell.seq.load(std::memory_order_acquire) != _head + 1) {
+			return false;
+		}
+		a_item = cell.item;
+		cell.seq.store(_head + CAPACITY, std::memory_order_release);
+		++_head;
+		return true;
+	}
+
+private:
+	static constexpr std::size_t MASK = CAPACITY - 1;
+	static_assert((CAPACITY & MASK) == 0, "capacity must be a power of two");
+
+	struct alignas(64) Cell
+	{
+		std::atomic<std::size_t> seq{ 0 };
+		T                        item;
+	};
+
+	std::array<Cell, CAPACITY> _cells;
+	alignas(64) std::atomic<std::size_t> _tail{ 0 };
+	alignas(64) std::size_t _head{ 0 };
+};
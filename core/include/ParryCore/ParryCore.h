@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+
+#include "ActorStateTable.h"
+
+/*Parry decision logic, independent of the game.
+The plugin describes actors and the world through the plain value types below (filled from CommonLibSSE in EldenParry.cpp
+and Utils.hpp); everything here is a pure function of them, so it can be built, profiled and checked outside the game.*/
+namespace ParryCore
+{
+	struct Vec3
+	{
+		float x{ 0.0f };
+		float y{ 0.0f };
+		float z{ 0.0f };
+
+		Vec3 operator+(const Vec3& a_rhs) const { return { x + a_rhs.x, y + a_rhs.y, z + a_rhs.z }; }
+		Vec3 operator-(const Vec3& a_rhs) const { return { x - a_rhs.x, y - a_rhs.y, z - a_rhs.z }; }
+		Vec3 operator*(float a_scalar) const { return { x * a_scalar, y * a_scalar, z * a_scalar }; }
+		Vec3 operator/(float a_scalar) const { return { x / a_scalar, y / a_scalar, z / a_scalar }; }
+		bool operator==(const Vec3&) const = default;
+
+		float dot(const Vec3& a_rhs) const { return x * a_rhs.x + y * a_rhs.y + z * a_rhs.z; }
+		float sqrLength() const { return dot(*this); }
+		float length() const;
+		/*Normalize in place, same as NiPoint3::Unitize: a (near) zero vector becomes zero.
+		@return the length before normalization.*/
+		float unitize();
+	};
+
+	/*Where an actor stands and which way it faces.*/
+	struct Pose
+	{
+		Vec3  position;
+		float yaw{ 0.0f };  // rotation around z in radians, game convention: 0 faces +y, clockwise.
+	};
+
+	/*Parry window, in seconds since the bash started timing.*/
+	struct ParryWindow
+	{
+		float start{ 0.0f };
+		float end{ 0.3f };
+
+		bool contains(double a_elapsed) const { return a_elapsed >= start && a_elapsed <= end; }
+		/*Seconds left in the window; 0 if a_elapsed is outside of it.*/
+		double remaining(double a_elapsed) const { return contains(a_elapsed) ? end - a_elapsed : 0.0; }
+	};
+
+	/*Angle from the facing direction of a_from to a_target, in degrees in [-180, 180]. Same as TESObjectREFR::GetHeadingAngle.*/
+	float headingAngle(const Pose& a_from, const Vec3& a_target);
+
+	/*True if a_target is within a_maxAngle degrees of the blocker's facing direction, on either side.*/
+	bool inBlockAngle(const Pose& a_blocker, const Vec3& a_target, float a_maxAngle);
+
+	/*True if the actor can parry something at a_target: their parry window is open at a_now and the target is within their block angle.
+	@param a_state: the actor's state; nullptr if they have none.*/
+	bool canParry(const ActorState* a_state, double a_now, const ParryWindow& a_window, const Pose& a_parrier, const Vec3& a_target, float a_blockAngle);
+
+	/*Score weights from the riposte settings.*/
+	struct ScoreWeights
+	{
+		double shieldScore{ 70.0 };
+		double weaponSkillWeight{ 1.0 };
+		double femaleScore{ -10.0 };
+		double playerScore{ 0.0 };
+		double powerAttackScore{ 25.0 };
+	};
+
+	/*What the score depends on, besides the attack itself.*/
+	struct ScoreInputs
+	{
+		bool   shield{ false };       // a shield is equipped in the left hand; the weapon is ignored.
+		double weaponScore{ 0.0 };    // weapon class bonus; unused with a shield.
+		double skillLevel{ 0.0 };     // level of the skill of the shield or weapon; 0 if none.
+		double raceScore{ 0.0 };
+		bool   female{ false };
+		bool   player{ false };
+	};
+
+	/*Part of the riposte score that only changes with equipment, skills or race.*/
+	double staticScore(const ScoreInputs& a_inputs, const ScoreWeights& a_weights);
+
+	/*Riposte score of an attack.*/
+	double attackScore(double a_staticScore, bool a_powerAttack, const ScoreWeights& a_weights);
+
+	/*Who staggers after a parry, and how hard.*/
+	enum class StaggerTier : std::uint8_t
+	{
+		kDefenderLarge,
+		kDefender,
+		kAttacker,
+		kAttackerLarge
+	};
+
+	/*Stagger outcome of a parry.
+	@param a_reprisal: attacker's score minus the defender's.*/
+	StaggerTier staggerTier(double a_reprisal);
+
+	/*Chance in [0, 1] that an NPC tries to parry a swing.
+	@param a_baseChance: chance against a swing the parry would stagger normally.
+	@param a_reprisal: attacker's score minus the defender's; the harder the parry would backfire, the less likely it is tried.*/
+	float parryLikelihood(float a_baseChance, double a_reprisal);
+
+	/*End a bash: close the parry window and, if a_settleCost, settle the stamina cost held for the bash.
+	@return the stamina to charge: the cached cost, unless the bash parried something.*/
+	float finishBash(ActorState& a_state, bool a_settleCost);
+
+	/// <summary>
+	/// Solve the velocity for a projectile to hit a moving target.
+	/// http://ringofblades.com/Blades/Code/PredictiveAim.cs
+	/// </summary>
+	/// <param name="a_projectileVelocity">In: current velocity, only its speed is used. Out: velocity to hit the target.</param>
+	/// <returns>True if an exact solution was found; otherwise a_projectileVelocity aims at where the target will be in 1 second.</returns>
+	bool predictAim(const Vec3& a_projectilePos, const Vec3& a_targetPosition, const Vec3& a_targetVelocity, float a_gravity, Vec3& a_projectileVelocity);
+}
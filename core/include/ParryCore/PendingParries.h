@@ -0,0 +1,79 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <span>
+
+/*Parries resolved ahead of the hits, as (attacker, parrier) pairs of native handles.
+Republished as a whole once per physics step by a single writer; hit callbacks look pairs up without taking any lock.
+The whole set is guarded by one sequence counter, and a reader that observed a publication in progress retries.*/
+class PendingParries
+{
+public:
+	using Key = std::uint32_t;
+
+	static constexpr std::size_t CAPACITY = 32;
+
+	struct Pair
+	{
+		Key attacker;
+		Key parrier;
+	};
+
+	/*Replace the pending parries. Single writer. Pairs beyond CAPACITY are dropped; their hits are resolved the slow way.
+	@param a_time: time the pairs were resolved at.*/
+	void publish(std::span<const Pair> a_pairs, double a_time)
+	{
+		const auto count = std::min(a_pairs.size(), CAPACITY);
+		auto seq = _seq.load(std::memory_order_relaxed);
+		_seq.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for (std::size_t i = 0; i < count; ++i) {
+			_pairs[i].store(pack(a_pairs[i]), std::memory_order_relaxed);
+		}
+		_count.store(static_cast<std::uint32_t>(count), std::memory_order_relaxed);
+		_time.store(a_time, std::memory_order_relaxed);
+		_seq.store(seq + 2, std::memory_order_release);
+	}
+
+	/*Drop all pending parries. Single writer.*/
+	void clear() { publish({}, 0.0); }
+
+	/*True if the parrier was found to parry the attacker no earlier than a_resolvedAfter. Lock-free, any thread.*/
+	bool contains(Key a_attacker, Key a_parrier, double a_resolvedAfter) const
+	{
+		const auto wanted = pack({ a_attacker, a_parrier });
+		while (true) {
+			auto seq = _seq.load(std::memory_order_acquire);
+			if (seq & 1) {
+				continue;
+			}
+			bool found = false;
+			if (_time.load(std::memory_order_relaxed) >= a_resolvedAfter) {
+				const auto count = _count.load(std::memory_order_relaxed);
+				for (std::uint32_t i = 0; i < count && !found; ++i) {
+					found = _pairs[i].load(std::memory_order_relaxed) == wanted;
+				}
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (_seq.load(std::memory_order_relaxed) == seq) {
+				return found;
+			}
+		}
+	}
+
+	/*Number of pending parries. Lock-free; a hint only.*/
+	std::uint32_t size() const { return _count.load(std::memory_order_relaxed); }
+
+private:
+	static std::uint64_t pack(const Pair& a_pair)
+	{
+		return (static_cast<std::uint64_t>(a_pair.attacker) << 32) | a_pair.parrier;
+	}
+
+	std::atomic<std::uint32_t>                       _seq{ 0 };
+	std::atomic<std::uint32_t>                       _count{ 0 };
+	std::atomic<double>                              _time{ 0.0 };
+	std::array<std::atomic<std::uint64_t>, CAPACITY> _pairs{};
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <unordered_set>
+
+#include "Trace.h"
+
+namespace ParryCore
+{
+	struct ReplayStats
+	{
+		std::uint64_t records{ 0 };
+		std::uint64_t decisions{ 0 };     // hits and contacts evaluated.
+		std::uint64_t parries{ 0 };       // decisions replayed as parried.
+		std::uint64_t skipped{ 0 };       // decisions on actors whose bash started before the trace did, or before a gap.
+		std::uint64_t gaps{ 0 };          // places where the recorder dropped records.
+		std::uint64_t mismatches{ 0 };    // replayed outcomes (parry, stagger tier, stamina charged) that differ from the recording.
+	};
+
+	/*Feeds a recorded trace through the parry core and checks that it reaches the recorded outcomes.*/
+	class Replayer
+	{
+	public:
+		explicit Replayer(const TraceHeader& a_header);
+
+		/*Replay one record. Records must be fed oldest first.
+		@return false if the replayed outcome differs from the recorded one.*/
+		bool feed(const TraceRecord& a_record);
+
+		const ReplayStats& stats() const { return _stats; }
+
+	private:
+		double expiredBefore(double a_now) const { return a_now - _window.end; }
+
+		bool decide(const TraceRecord& a_record);
+
+		ParryWindow                       _window;
+		float                             _blockAngle;
+		bool                              _settleCost;
+		bool                              _scoredStaggers;  // kStagger records carry both scores.
+		ActorStateTable                   _states;
+		std::unordered_set<std::uint32_t> _known;  // actors whose bash history is in the trace.
+		ReplayStats                       _stats;
+	};
+}
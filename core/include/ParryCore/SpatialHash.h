@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ParryCore.h"
+
+namespace ParryCore
+{
+	/*Uniform grid over the xy plane, rebuilt from scratch whenever the positions change (e.g. once per frame).
+	Entries are sorted by cell, so the entries of a cell are contiguous and a query is one binary search per visited cell.
+	Heights are ignored for bucketing but not for the distance test.*/
+	class SpatialHash
+	{
+	public:
+		/*Index a_positions. Queries report indices into a_positions, which must not change until the next build.*/
+		void build(std::span<const Vec3> a_positions, float a_cellSize);
+
+		/*Call a_visit(index) for every indexed position within a_radius of a_center, in no particular order.*/
+		template <class Visitor>
+		void query(const Vec3& a_center, float a_radius, Visitor&& a_visit) const
+		{
+			const float sqrRadius = a_radius * a_radius;
+			const auto  minX = cellCoord(a_center.x - a_radius), maxX = cellCoord(a_center.x + a_radius);
+			const auto  minY = cellCoord(a_center.y - a_radius), maxY = cellCoord(a_center.y + a_radius);
+			for (auto x = minX; x <= maxX; ++x) {
+				for (auto y = minY; y <= maxY; ++y) {
+					const auto key = cellKey(x, y);
+					auto       it = std::ranges::lower_bound(_entries, key, {}, &Entry::cell);
+					for (; it != _entries.end() && it->cell == key; ++it) {
+						if ((_positions[it->index] - a_center).sqrLength() <= sqrRadius) {
+							a_visit(it->index);
+						}
+					}
+				}
+			}
+		}
+
+		std::size_t size() const { return _entries.size(); }
+
+	private:
+		struct Entry
+		{
+			std::uint64_t cell;
+			std::uint32_t index;
+		};
+
+		std::int32_t cellCoord(float a_coord) const { return static_cast<std::int32_t>(std::floor(a_coord / _cellSize)); }
+
+		static std::uint64_t cellKey(std::int32_t a_x, std::int32_t a_y)
+		{
+			return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(a_x)) << 32) | static_cast<std::uint32_t>(a_y);
+		}
+
+		std::vector<Entry>    _entries;
+		std::span<const Vec3> _positions;
+		float                 _cellSize{ 256.0f };
+	};
+}
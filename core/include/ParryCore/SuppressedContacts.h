@@ -0,0 +1,107 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/*Parried swings whose remaining contacts are dropped, as (attacker, parrier) pairs of collision groups.
+Queried by the collision filter, which runs hundreds of times per frame on havok threads: a query is a single load
+when the set is empty, and a scan of a few cache lines otherwise. Insertions may come from any thread and never block.
+An entry lives as long as the swing: the owner calls sweep() once per frame to drop the swings that ended.*/
+class SuppressedContacts
+{
+public:
+	using Group = std::uint16_t;
+	using Key = std::uint32_t;  // native handle of an actor.
+
+	static constexpr std::size_t CAPACITY = 16;
+
+	/*Drop contacts between the attacker's and the parrier's bodies until sweep() ends the swing.
+	Group 0 (no group assigned) and pairs within one group are rejected, as they would match unrelated bodies.
+	@return false if the pair was rejected or the set is full; its contacts then go through the hit callbacks as usual.*/
+	bool add(Group a_attacker, Group a_parrier, Key a_attackerHandle, Key a_parrierHandle)
+	{
+		if (a_attacker == 0 || a_parrier == 0 || a_attacker == a_parrier) {
+			return false;
+		}
+		const auto pair = pairOf(a_attacker, a_parrier);
+		for (const auto& slot : _slots) {
+			if (slot.pair.load(std::memory_order_relaxed) == pair) {
+				return true;
+			}
+		}
+		for (auto& slot : _slots) {
+			auto expected = EMPTY;
+			if (!slot.pair.compare_exchange_strong(expected, RESERVED, std::memory_order_acquire, std::memory_order_relaxed)) {
+				continue;
+			}
+			slot.attacker.store(a_attackerHandle, std::memory_order_relaxed);
+			slot.parrier.store(a_parrierHandle, std::memory_order_relaxed);
+			slot.pair.store(pair, std::memory_order_release);
+			_live.fetch_add(1, std::memory_order_release);
+			return true;
+		}
+		return false;
+	}
+
+	/*True if contacts between the two groups are dropped. The filter can't tell which body swings, so either group
+	may be the attacker's; the direction is kept by sweep(), which ends the entry before the parrier can swing back.
+	Lock-free, any thread.*/
+	bool contains(Group a_lhs, Group a_rhs) const
+	{
+		if (_live.load(std::memory_order_acquire) == 0) {
+			return false;
+		}
+		const auto forward = pairOf(a_lhs, a_rhs);
+		const auto backward = pairOf(a_rhs, a_lhs);
+		for (const auto& slot : _slots) {
+			auto pair = slot.pair.load(std::memory_order_acquire);
+			if (pair == forward || pair == backward) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/*Drop every entry for which a_swingGoesOn(attackerHandle, parrierHandle) returns false. Call from one thread.*/
+	template <class Fn>
+	void sweep(Fn&& a_swingGoesOn)
+	{
+		if (_live.load(std::memory_order_acquire) == 0) {
+			return;
+		}
+		for (auto& slot : _slots) {
+			auto pair = slot.pair.load(std::memory_order_acquire);
+			if (pair == EMPTY || pair == RESERVED) {
+				continue;
+			}
+			if (!a_swingGoesOn(slot.attacker.load(std::memory_order_relaxed), slot.parrier.load(std::memory_order_relaxed)) &&
+				slot.pair.compare_exchange_strong(pair, EMPTY, std::memory_order_release, std::memory_order_relaxed)) {
+				_live.fetch_sub(1, std::memory_order_release);
+			}
+		}
+	}
+
+	/*Drop all entries. Call from the thread that calls sweep().*/
+	void clear()
+	{
+		sweep([](Key, Key) { return false; });
+	}
+
+	std::uint32_t size() const { return _live.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr std::uint32_t EMPTY = 0;
+	static constexpr std::uint32_t RESERVED = 0xFFFFFFFF;  // being filled in by add(); never a valid pair, as both groups would be equal.
+
+	struct Slot
+	{
+		std::atomic<std::uint32_t> pair{ EMPTY };
+		std::atomic<Key>           attacker{ 0 };
+		std::atomic<Key>           parrier{ 0 };
+	};
+
+	static std::uint32_t pairOf(Group a_attacker, Group a_parrier) { return (static_cast<std::uint32_t>(a_attacker) << 16) | a_parrier; }
+
+	std::array<Slot, CAPACITY> _slots{};
+	std::atomic<std::uint32_t> _live{ 0 };
+};
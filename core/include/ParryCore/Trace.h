@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ParryCore.h"
+
+/*Combat trace: every input EldenParry decides on, in a fixed-capacity ring file.
+The file is a TraceHeader followed by `capacity` TraceRecord slots; once full, the oldest records are overwritten.*/
+namespace ParryCore
+{
+	struct TraceRecord
+	{
+		enum class Type : std::uint8_t
+		{
+			kBashStart,          // actor started timing a parry.
+			kBashEnd,            // actor's bash ended; value is the stamina charged.
+			kStaminaCost,        // stamina cost cached for actor's bash; value is the cost.
+			kMeleeHit,           // other (attacker handle) hit actor; pose is actor's, target the attacker's position.
+			kProjectileContact,  // other (projectile handle) touched actor; pose is actor's, target the projectile's position.
+			kStagger,            // stagger after a parry by actor against other; target.x/y are other's and actor's scores, value the reprisal, tier the outcome.
+			kConfig,             // settings reloaded; value is the block angle, target.x/y the parry window, flag kSettleCost.
+			kGap,                // records were dropped before this one; the state of every actor is unknown from here.
+		};
+
+		enum Flag : std::uint8_t
+		{
+			kNone = 0,
+			kParried = 1 << 0,     // the hit or contact was parried.
+			kSettleCost = 1 << 1,  // kConfig: same as TraceHeader::kSettleCost.
+		};
+
+		double        time{ 0.0 };  // parry clock, in seconds.
+		std::uint32_t actor{ 0 };
+		std::uint32_t other{ 0 };
+		Type          type{ Type::kBashStart };
+		std::uint8_t  flags{ kNone };
+		StaggerTier   tier{ StaggerTier::kDefenderLarge };
+		std::uint8_t  pad{ 0 };
+		float         value{ 0.0f };
+		Pose          pose;
+		Vec3          target;
+		std::uint32_t reserved[3]{};
+	};
+	static_assert(sizeof(TraceRecord) == 64);
+
+	struct TraceHeader
+	{
+		static constexpr char          MAGIC[4]{ 'E', 'P', 'T', 'R' };
+		static constexpr std::uint32_t VERSION = 2;  // 2: kConfig and kGap records, scores on kStagger.
+
+		enum Flag : std::uint32_t
+		{
+			kNone = 0,
+			kSettleCost = 1 << 0,  // bashes are charged their cost unless they parried (bSuccessfulParryNoCost).
+		};
+
+		char          magic[4]{ MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3] };
+		std::uint32_t version{ VERSION };
+		std::uint32_t recordSize{ sizeof(TraceRecord) };
+		std::uint32_t capacity{ 0 };
+		std::uint64_t written{ 0 };  // records written since the trace started; slot of the next one is written % capacity.
+		ParryWindow   window;  // settings when the trace started; kConfig records carry later changes.
+		float         blockAngle{ 0.0f };
+		std::uint32_t flags{ kNone };
+		std::uint32_t reserved{ 0 };
+	};
+
+	class TraceWriter
+	{
+	public:
+		/*Create the file, truncating any previous trace.
+		@param a_header: settings the trace is recorded with; capacity must be set.*/
+		bool open(const std::string& a_path, const TraceHeader& a_header);
+
+		void write(const TraceRecord* a_records, std::size_t a_count);
+
+		/*Write the header, making the records written so far visible to readers.*/
+		void flush();
+
+		bool isOpen() const { return _file.is_open(); }
+
+	private:
+		std::fstream _file;
+		TraceHeader  _header;
+	};
+
+	class TraceReader
+	{
+	public:
+		bool open(const std::string& a_path);
+
+		const TraceHeader& header() const { return _header; }
+
+		/*All records still in the ring, oldest first.*/
+		std::vector<TraceRecord> readAll();
+
+	private:
+		std::ifstream _file;
+		TraceHeader   _header;
+	};
+}
@@ -0,0 +1,208 @@
+#include "ParryCore/ParryCore.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numbers>
+
+namespace ParryCore
+{
+	namespace
+	{
+		bool approximatelyEqual(float a_lhs, float a_rhs)
+		{
+			return ((a_lhs - a_rhs) < FLT_EPSILON) && ((a_rhs - a_lhs) < FLT_EPSILON);
+		}
+	}
+
+	float Vec3::length() const
+	{
+		return std::sqrt(sqrLength());
+	}
+
+	float Vec3::unitize()
+	{
+		float len = length();
+		if (len == 1.0f) {
+			return len;
+		}
+		if (len > FLT_EPSILON) {
+			*this = *this / len;
+		} else {
+			*this = {};
+			len = 0.0f;
+		}
+		return len;
+	}
+
+	float headingAngle(const Pose& a_from, const Vec3& a_target)
+	{
+		float theta = std::atan2(a_target.x - a_from.position.x, a_target.y - a_from.position.y);
+		float heading = (theta - a_from.yaw) * (180.0f / std::numbers::pi_v<float>);
+		if (heading < -180.0f) {
+			heading += 360.0f;
+		}
+		if (heading > 180.0f) {
+			heading -= 360.0f;
+		}
+		return heading;
+	}
+
+	bool inBlockAngle(const Pose& a_blocker, const Vec3& a_target, float a_maxAngle)
+	{
+		auto angle = headingAngle(a_blocker, a_target);
+		return angle <= a_maxAngle && angle >= -a_maxAngle;
+	}
+
+	bool canParry(const ActorState* a_state, double a_now, const ParryWindow& a_window, const Pose& a_parrier, const Vec3& a_target, float a_blockAngle)
+	{
+		return a_state && a_state->has(ActorState::kTimingParry) &&
+		       a_window.contains(a_now - a_state->parryStart) &&
+		       inBlockAngle(a_parrier, a_target, a_blockAngle);
+	}
+
+	double staticScore(const ScoreInputs& a_inputs, const ScoreWeights& a_weights)
+	{
+		double score = a_inputs.shield ? a_weights.shieldScore : a_inputs.weaponScore;
+		score += a_weights.weaponSkillWeight * a_inputs.skillLevel;
+		score += a_inputs.raceScore;
+		if (a_inputs.female) {
+			score += a_weights.femaleScore;
+		}
+		if (a_inputs.player) {
+			score += a_weights.playerScore;
+		}
+		return score;
+	}
+
+	double attackScore(double a_staticScore, bool a_powerAttack, const ScoreWeights& a_weights)
+	{
+		return a_powerAttack ? a_staticScore + a_weights.powerAttackScore : a_staticScore;
+	}
+
+	StaggerTier staggerTier(double a_reprisal)
+	{
+		if (a_reprisal >= 30.0) {
+			return StaggerTier::kDefenderLarge;
+		}
+		if (a_reprisal >= 20.0) {
+			return StaggerTier::kDefender;
+		}
+		if (a_reprisal >= 10.0) {
+			return StaggerTier::kAttacker;
+		}
+		return StaggerTier::kAttackerLarge;
+	}
+
+	float parryLikelihood(float a_baseChance, double a_reprisal)
+	{
+		float scale = 1.0f;
+		switch (staggerTier(a_reprisal)) {
+		case StaggerTier::kDefenderLarge:
+			scale = 0.25f;
+			break;
+		case StaggerTier::kDefender:
+			scale = 0.5f;
+			break;
+		case StaggerTier::kAttacker:
+			scale = 1.0f;
+			break;
+		case StaggerTier::kAttackerLarge:
+			scale = 1.5f;
+			break;
+		}
+		return std::clamp(a_baseChance * scale, 0.0f, 1.0f);
+	}
+
+	float finishBash(ActorState& a_state, bool a_settleCost)
+	{
+		a_state.clear(ActorState::kTimingParry);
+		if (!a_settleCost) {
+			return 0.0f;
+		}
+		float due = a_state.has(ActorState::kParryCostCached) && !a_state.has(ActorState::kParrySucceeded) ? a_state.parryCost : 0.0f;
+		a_state.clear(ActorState::kParryCostCached);
+		a_state.clear(ActorState::kParrySucceeded);
+		return due;
+	}
+
+	bool predictAim(const Vec3& a_projectilePos, const Vec3& a_targetPosition, const Vec3& a_targetVelocity, float a_gravity, Vec3& a_projectileVelocity)
+	{
+		float projectileSpeedSquared = a_projectileVelocity.sqrLength();
+		float projectileSpeed = std::sqrt(projectileSpeedSquared);
+
+		if (projectileSpeed <= 0.f || a_projectilePos == a_targetPosition) {
+			return false;
+		}
+
+		float targetSpeedSquared = a_targetVelocity.sqrLength();
+		float targetSpeed = std::sqrt(targetSpeedSquared);
+		Vec3  targetToProjectile = a_projectilePos - a_targetPosition;
+		float distanceSquared = targetToProjectile.sqrLength();
+		float distance = std::sqrt(distanceSquared);
+		Vec3  direction = targetToProjectile;
+		direction.unitize();
+		Vec3 targetVelocityDirection = a_targetVelocity;
+		targetVelocityDirection.unitize();
+
+		float cosTheta = (targetSpeedSquared > 0) ? direction.dot(targetVelocityDirection) : 1.0f;
+
+		bool  bValidSolutionFound = true;
+		float t;
+
+		if (approximatelyEqual(projectileSpeedSquared, targetSpeedSquared)) {
+			// We want to avoid div/0 that can result from target and projectile traveling at the same speed
+			//We know that cos(theta) of zero or less means there is no solution, since that would mean B goes backwards or leads to div/0 (infinity)
+			if (cosTheta > 0) {
+				t = 0.5f * distance / (targetSpeed * cosTheta);
+			} else {
+				bValidSolutionFound = false;
+				t = 1;
+			}
+		} else {
+			float a = projectileSpeedSquared - targetSpeedSquared;
+			float b = 2.0f * distance * targetSpeed * cosTheta;
+			float c = -distanceSquared;
+			float discriminant = b * b - 4.0f * a * c;
+
+			if (discriminant < 0) {
+				// NaN
+				bValidSolutionFound = false;
+				t = 1;
+			} else {
+				// a will never be zero
+				float uglyNumber = std::sqrt(discriminant);
+				float t0 = 0.5f * (-b + uglyNumber) / a;
+				float t1 = 0.5f * (-b - uglyNumber) / a;
+
+				// Assign the lowest positive time to t to aim at the earliest hit
+				t = (std::min)(t0, t1);
+				if (t < FLT_EPSILON) {
+					t = (std::max)(t0, t1);
+				}
+
+				if (t < FLT_EPSILON) {
+					// Time can't flow backwards when it comes to aiming.
+					// No real solution was found, take a wild shot at the target's future location
+					bValidSolutionFound = false;
+					t = 1;
+				}
+			}
+		}
+
+		a_projectileVelocity = a_targetVelocity + (targetToProjectile * -1.0f) / t;
+
+		if (!bValidSolutionFound) {
+			a_projectileVelocity.unitize();
+			a_projectileVelocity = a_projectileVelocity * projectileSpeed;
+		}
+
+		if (!approximatelyEqual(a_gravity, 0.f)) {
+			float netFallDistance = (a_projectileVelocity * t).z;
+			float gravityCompensationSpeed = (netFallDistance + 0.5f * a_gravity * t * t) / t;
+			a_projectileVelocity.z = gravityCompensationSpeed;
+		}
+
+		return bValidSolutionFound;
+	}
+}
@@ -0,0 +1,100 @@
+#include "ParryCore/Replay.h"
+
+#include <cmath>
+
+namespace ParryCore
+{
+	Replayer::Replayer(const TraceHeader& a_header) :
+		_window(a_header.window),
+		_blockAngle(a_header.blockAngle),
+		_settleCost((a_header.flags & TraceHeader::kSettleCost) != 0),
+		_scoredStaggers(a_header.version >= 2)
+	{}
+
+	bool Replayer::feed(const TraceRecord& a_record)
+	{
+		++_stats.records;
+		bool matches = true;
+		switch (a_record.type) {
+		case TraceRecord::Type::kBashStart:
+			_known.insert(a_record.actor);
+			_states.modify(
+				a_record.actor, [&a_record](ActorState& a_state) {
+					a_state.parryStart = a_record.time;
+					a_state.set(ActorState::kTimingParry);
+				},
+				expiredBefore(a_record.time));
+			break;
+		case TraceRecord::Type::kBashEnd:
+			{
+				float due = 0.0f;
+				_states.modify(
+					a_record.actor, [this, &due](ActorState& a_state) {
+						due = finishBash(a_state, _settleCost);
+					},
+					expiredBefore(a_record.time));
+				// the cost of a bash that started before the trace is unknown.
+				matches = !_known.contains(a_record.actor) || std::abs(due - a_record.value) < 1e-3f;
+				_known.insert(a_record.actor);
+			}
+			break;
+		case TraceRecord::Type::kStaminaCost:
+			_states.modify(
+				a_record.actor, [&a_record](ActorState& a_state) {
+					a_state.parryCost = a_record.value;
+					a_state.set(ActorState::kParryCostCached);
+				},
+				expiredBefore(a_record.time));
+			break;
+		case TraceRecord::Type::kMeleeHit:
+		case TraceRecord::Type::kProjectileContact:
+			matches = decide(a_record);
+			break;
+		case TraceRecord::Type::kStagger:
+			{
+				// version 1 traces only have the reprisal.
+				const double reprisal = _scoredStaggers ? static_cast<double>(a_record.target.x) - a_record.target.y : a_record.value;
+				matches = staggerTier(reprisal) == a_record.tier && std::abs(reprisal - a_record.value) < 1e-2;
+			}
+			break;
+		case TraceRecord::Type::kConfig:
+			_window = { a_record.target.x, a_record.target.y };
+			_blockAngle = a_record.value;
+			_settleCost = (a_record.flags & TraceRecord::kSettleCost) != 0;
+			break;
+		case TraceRecord::Type::kGap:
+			// the dropped records may have started or ended any bash: start over, as at the beginning of the trace.
+			++_stats.gaps;
+			_known.clear();
+			_states.clear();
+			break;
+		}
+		if (!matches) {
+			++_stats.mismatches;
+		}
+		return matches;
+	}
+
+	bool Replayer::decide(const TraceRecord& a_record)
+	{
+		++_stats.decisions;
+		if (!_known.contains(a_record.actor)) {
+			++_stats.skipped;
+			return true;
+		}
+		ActorState state;
+		bool       found = _states.find(a_record.actor, state);
+		bool       parried = canParry(found ? &state : nullptr, a_record.time, _window, a_record.pose, a_record.target, _blockAngle);
+		if (parried) {
+			++_stats.parries;
+			if (_settleCost) {
+				_states.modify(
+					a_record.actor, [](ActorState& a_state) {
+						a_state.set(ActorState::kParrySucceeded);
+					},
+					expiredBefore(a_record.time));
+			}
+		}
+		return parried == ((a_record.flags & TraceRecord::kParried) != 0);
+	}
+}
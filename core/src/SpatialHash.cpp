@@ -0,0 +1,16 @@
+#include "ParryCore/SpatialHash.h"
+
+namespace ParryCore
+{
+	void SpatialHash::build(std::span<const Vec3> a_positions, float a_cellSize)
+	{
+		_cellSize = std::max(a_cellSize, 1.0f);
+		_positions = a_positions;
+		_entries.clear();
+		_entries.reserve(a_positions.size());
+		for (std::uint32_t i = 0; i < a_positions.size(); ++i) {
+			_entries.push_back({ cellKey(cellCoord(a_positions[i].x), cellCoord(a_positions[i].y)), i });
+		}
+		std::ranges::sort(_entries, {}, &Entry::cell);
+	}
+}
@@ -0,0 +1,73 @@
+#include "ParryCore/Trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ParryCore
+{
+	bool TraceWriter::open(const std::string& a_path, const TraceHeader& a_header)
+	{
+		if (a_header.capacity == 0) {
+			return false;
+		}
+		_header = a_header;
+		_header.written = 0;
+		_file.open(a_path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+		if (!_file) {
+			return false;
+		}
+		flush();
+		return static_cast<bool>(_file);
+	}
+
+	void TraceWriter::write(const TraceRecord* a_records, std::size_t a_count)
+	{
+		while (a_count > 0) {
+			// write up to the end of the ring in one go.
+			auto slot = _header.written % _header.capacity;
+			auto run = (std::min)(a_count, static_cast<std::size_t>(_header.capacity - slot));
+			_file.seekp(static_cast<std::streamoff>(sizeof(TraceHeader) + slot * sizeof(TraceRecord)));
+			_file.write(reinterpret_cast<const char*>(a_records), static_cast<std::streamsize>(run * sizeof(TraceRecord)));
+			_header.written += run;
+			a_records += run;
+			a_count -= run;
+		}
+	}
+
+	void TraceWriter::flush()
+	{
+		_file.seekp(0);
+		_file.write(reinterpret_cast<const char*>(&_header), sizeof(TraceHeader));
+		_file.flush();
+	}
+
+	bool TraceReader::open(const std::string& a_path)
+	{
+		_file.open(a_path, std::ios::binary);
+		if (!_file.read(reinterpret_cast<char*>(&_header), sizeof(TraceHeader))) {
+			return false;
+		}
+		return std::memcmp(_header.magic, TraceHeader::MAGIC, sizeof(TraceHeader::MAGIC)) == 0 &&
+		       _header.version >= 1 && _header.version <= TraceHeader::VERSION &&
+		       _header.recordSize == sizeof(TraceRecord) &&
+		       _header.capacity > 0;
+	}
+
+	std::vector<TraceRecord> TraceReader::readAll()
+	{
+		const auto count = static_cast<std::size_t>((std::min)(_header.written, static_cast<std::uint64_t>(_header.capacity)));
+		const auto oldest = _header.written > _header.capacity ? static_cast<std::size_t>(_header.written % _header.capacity) : 0;
+
+		std::vector<TraceRecord> records(count);
+		auto readSlots = [&](std::size_t a_slot, std::size_t a_count, TraceRecord* a_out) {
+			_file.seekg(static_cast<std::streamoff>(sizeof(TraceHeader) + a_slot * sizeof(TraceRecord)));
+			_file.read(reinterpret_cast<char*>(a_out), static_cast<std::streamsize>(a_count * sizeof(TraceRecord)));
+		};
+		readSlots(oldest, count - oldest, records.data());
+		readSlots(0, oldest, records.data() + (count - oldest));
+		if (!_file) {
+			records.clear();
+		}
+		return records;
+	}
+}
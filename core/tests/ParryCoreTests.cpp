@@ -0,0 +1,308 @@
+/*Tests of the parry core, run by ctest. Each test is a plain function; CHECK records a failure and carries on.*/
+#include "ParryCore/ActorStateTable.h"
+#include "ParryCore/ParryCore.h"
+#include "ParryCore/PendingParries.h"
+#include "ParryCore/Replay.h"
+#include "ParryCore/SuppressedContacts.h"
+
+#include <atomic>
+#include <cstdio>
+#include <numbers>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	int failures = 0;
+
+#define CHECK(a_condition)                                                                   \
+	do {                                                                                     \
+		if (!(a_condition)) {                                                                \
+			std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #a_condition); \
+			++failures;                                                                      \
+		}                                                                                    \
+	} while (false)
+
+	using namespace ParryCore;
+
+	ActorState timingSince(double a_start)
+	{
+		ActorState state;
+		state.parryStart = a_start;
+		state.set(ActorState::kTimingParry);
+		return state;
+	}
+
+	void testActorStateTable()
+	{
+		ActorStateTable table;
+		ActorState      state;
+		CHECK(!table.find(1, state));
+		CHECK(table.modify(1, [](ActorState& a_state) { a_state = timingSince(2.0); }, 0.0));
+		CHECK(table.find(1, state) && state.has(ActorState::kTimingParry) && state.parryStart == 2.0);
+		CHECK(table.timingCount() == 1);
+
+		// a record left without flags is dropped.
+		CHECK(table.modify(1, [](ActorState& a_state) { a_state.clear(ActorState::kTimingParry); }, 0.0));
+		CHECK(!table.find(1, state));
+
+		// a full table refuses new records, but stale windows and cached scores give their slots up.
+		for (ActorStateTable::Key key = 1; key <= ActorStateTable::CAPACITY; ++key) {
+			CHECK(table.modify(key, [](ActorState& a_state) { a_state = timingSince(1.0); }, 0.0));
+		}
+		// the callback isn't run for a record that can't be stored, so nothing is traced for it.
+		bool called = false;
+		CHECK(!table.modify(1000, [&called](ActorState& a_state) {
+			called = true;
+			a_state = timingSince(5.0);
+		}, 0.0));
+		CHECK(!called);
+		CHECK(table.modify(1000, [](ActorState& a_state) { a_state = timingSince(5.0); }, 2.0));
+		CHECK(table.find(1000, state));
+
+		table.clear();
+		for (ActorStateTable::Key key = 1; key <= ActorStateTable::CAPACITY; ++key) {
+			table.modify(key, [](ActorState& a_state) { a_state.set(ActorState::kScoreCached); }, 0.0);
+		}
+		CHECK(table.modify(1000, [](ActorState& a_state) { a_state = timingSince(5.0); }, 0.0));
+	}
+
+	/*Readers must never observe a half-written record: the writer keeps all fields of the record equal.*/
+	void testActorStateTableClearExpired()
+	{
+		ActorStateTable table;
+		// a bash interrupted without bashStop, and one that also cached its stamina cost.
+		CHECK(table.modify(1, [](ActorState& a_state) { a_state = timingSince(0.0); }, 0.0));
+		CHECK(table.modify(2, [](ActorState& a_state) {
+			a_state = timingSince(0.0);
+			a_state.parryCost = 5.0f;
+			a_state.set(ActorState::kParryCostCached);
+		}, 0.0));
+		CHECK(table.modify(3, [](ActorState& a_state) { a_state = timingSince(1.0); }, 0.0));
+		CHECK(table.timingCount() == 3);
+
+		table.clearExpired(0.5);
+		CHECK(table.timingCount() == 1);
+		ActorState state;
+		CHECK(!table.find(1, state));
+		CHECK(table.find(2, state) && !state.has(ActorState::kTimingParry) && state.has(ActorState::kParryCostCached));
+		CHECK(table.find(3, state) && state.has(ActorState::kTimingParry));
+
+		table.clearExpired(1.5);
+		CHECK(table.timingCount() == 0);
+	}
+
+	void testActorStateTableSeqlock()
+	{
+		ActorStateTable   table;
+		std::atomic<bool> stop{ false };
+		std::atomic<int>  torn{ 0 };
+		table.modify(7, [](ActorState& a_state) { a_state = timingSince(0.0); }, 0.0);
+
+		std::vector<std::jthread> readers;
+		for (int i = 0; i < 3; ++i) {
+			readers.emplace_back([&] {
+				ActorState state;
+				while (!stop.load(std::memory_order_relaxed)) {
+					if (table.find(7, state) && (state.parryCost != static_cast<float>(state.parryStart) || state.staticScore != state.parryCost)) {
+						torn.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+			});
+		}
+		for (int n = 1; n <= 200'000; ++n) {
+			table.modify(7, [n](ActorState& a_state) {
+				a_state.parryStart = n;
+				a_state.parryCost = static_cast<float>(n);
+				a_state.staticScore = static_cast<float>(n);
+			}, 0.0);
+		}
+		stop = true;
+		readers.clear();
+		CHECK(torn.load() == 0);
+	}
+
+	void testPendingParries()
+	{
+		PendingParries pending;
+		CHECK(!pending.contains(1, 2, 0.0));
+		const PendingParries::Pair pairs[]{ { 1, 2 }, { 3, 4 } };
+		pending.publish(pairs, 10.0);
+		CHECK(pending.contains(1, 2, 9.0));
+		CHECK(pending.contains(3, 4, 10.0));
+		CHECK(!pending.contains(2, 1, 9.0));   // directional.
+		CHECK(!pending.contains(1, 2, 10.5));  // too old.
+		pending.clear();
+		CHECK(!pending.contains(1, 2, 0.0));
+
+		std::vector<PendingParries::Pair> many(PendingParries::CAPACITY + 8);
+		for (std::uint32_t i = 0; i < many.size(); ++i) {
+			many[i] = { i + 1, i + 100 };
+		}
+		pending.publish(many, 1.0);
+		CHECK(pending.size() == PendingParries::CAPACITY);
+		CHECK(pending.contains(1, 100, 0.0));
+		CHECK(!pending.contains(static_cast<std::uint32_t>(many.size()), static_cast<std::uint32_t>(many.size()) + 99, 0.0));
+	}
+
+	void testSuppressedContacts()
+	{
+		SuppressedContacts contacts;
+		CHECK(!contacts.contains(1, 2));
+		CHECK(!contacts.add(0, 2, 10, 20));  // no group.
+		CHECK(!contacts.add(3, 3, 10, 20));  // same group.
+		CHECK(contacts.add(1, 2, 10, 20));
+		CHECK(contacts.contains(1, 2) && contacts.contains(2, 1));
+		CHECK(!contacts.contains(1, 3));
+		CHECK(contacts.add(1, 2, 10, 20) && contacts.size() == 1);  // already suppressed.
+
+		contacts.sweep([](SuppressedContacts::Key a_attacker, SuppressedContacts::Key) { return a_attacker != 10; });
+		CHECK(!contacts.contains(1, 2) && contacts.size() == 0);
+
+		for (SuppressedContacts::Group group = 1; group <= SuppressedContacts::CAPACITY; ++group) {
+			CHECK(contacts.add(group, 100, group, 100));
+		}
+		CHECK(!contacts.add(50, 100, 50, 100));  // full.
+		contacts.clear();
+		CHECK(contacts.size() == 0 && !contacts.contains(1, 100));
+	}
+
+	void testCanParry()
+	{
+		const ParryWindow window{ 0.0f, 0.3f };
+		const Pose        parrier{ { 0.0f, 0.0f, 0.0f }, 0.0f };  // faces +y.
+		const Vec3        ahead{ 0.0f, 100.0f, 0.0f };
+		const Vec3        behind{ 0.0f, -100.0f, 0.0f };
+		const Vec3        aside{ 100.0f, 10.0f, 0.0f };
+		const auto        state = timingSince(1.0);
+
+		CHECK(canParry(&state, 1.1, window, parrier, ahead, 35.0f));
+		CHECK(canParry(&state, 1.0, window, parrier, ahead, 35.0f));
+		CHECK(!canParry(&state, 1.31, window, parrier, ahead, 35.0f));  // window over.
+		CHECK(!canParry(&state, 0.9, window, parrier, ahead, 35.0f));   // bash not started yet.
+		CHECK(!canParry(&state, 1.1, window, parrier, behind, 35.0f));
+		CHECK(!canParry(&state, 1.1, window, parrier, aside, 35.0f));
+		CHECK(canParry(&state, 1.1, window, parrier, aside, 90.0f));
+		CHECK(!canParry(nullptr, 1.1, window, parrier, ahead, 35.0f));
+
+		ActorState notTiming = state;
+		notTiming.clear(ActorState::kTimingParry);
+		CHECK(!canParry(&notTiming, 1.1, window, parrier, ahead, 35.0f));
+
+		// the yaw turns the block cone with the parrier.
+		const Pose turned{ { 0.0f, 0.0f, 0.0f }, std::numbers::pi_v<float> / 2.0f };  // faces +x.
+		CHECK(canParry(&state, 1.1, window, turned, { 100.0f, 0.0f, 0.0f }, 35.0f));
+		CHECK(!canParry(&state, 1.1, window, turned, ahead, 35.0f));
+	}
+
+	void testStaggerTier()
+	{
+		CHECK(staggerTier(45.0) == StaggerTier::kDefenderLarge);
+		CHECK(staggerTier(30.0) == StaggerTier::kDefenderLarge);
+		CHECK(staggerTier(29.9) == StaggerTier::kDefender);
+		CHECK(staggerTier(20.0) == StaggerTier::kDefender);
+		CHECK(staggerTier(19.9) == StaggerTier::kAttacker);
+		CHECK(staggerTier(10.0) == StaggerTier::kAttacker);
+		CHECK(staggerTier(9.9) == StaggerTier::kAttackerLarge);
+		CHECK(staggerTier(-100.0) == StaggerTier::kAttackerLarge);
+	}
+
+	void testReplayConfig()
+	{
+		TraceHeader header;
+		header.window = { 0.0f, 0.3f };
+		header.blockAngle = 60.0f;
+		Replayer replayer(header);
+
+		TraceRecord bash;
+		bash.type = TraceRecord::Type::kBashStart;
+		bash.actor = 1;
+		CHECK(replayer.feed(bash));
+
+		// settings reloaded mid-trace: the window shrinks, so a hit at 0.2 s is no longer parried.
+		TraceRecord config;
+		config.type = TraceRecord::Type::kConfig;
+		config.time = 0.1;
+		config.value = 60.0f;
+		config.target = { 0.0f, 0.15f, 0.0f };
+		CHECK(replayer.feed(config));
+
+		TraceRecord hit;
+		hit.type = TraceRecord::Type::kMeleeHit;
+		hit.time = 0.2;
+		hit.actor = 1;
+		hit.other = 2;
+		hit.target = { 0.0f, 100.0f, 0.0f };
+		CHECK(replayer.feed(hit));
+		CHECK(replayer.stats().parries == 0);
+		CHECK(replayer.stats().mismatches == 0);
+	}
+
+	void testReplayGap()
+	{
+		TraceHeader header;
+		header.blockAngle = 60.0f;
+		Replayer replayer(header);
+
+		TraceRecord bash;
+		bash.type = TraceRecord::Type::kBashStart;
+		bash.actor = 1;
+		CHECK(replayer.feed(bash));
+
+		// the kBashEnd that closed the window was dropped: the hit must not be checked against the stale window.
+		TraceRecord gap;
+		gap.type = TraceRecord::Type::kGap;
+		gap.time = 0.1;
+		CHECK(replayer.feed(gap));
+
+		TraceRecord hit;
+		hit.type = TraceRecord::Type::kMeleeHit;
+		hit.time = 0.1;
+		hit.actor = 1;
+		hit.target = { 0.0f, 100.0f, 0.0f };
+		CHECK(replayer.feed(hit));
+		CHECK(replayer.stats().gaps == 1);
+		CHECK(replayer.stats().skipped == 1);
+		CHECK(replayer.stats().mismatches == 0);
+	}
+
+	void testReplayStagger()
+	{
+		TraceHeader header;
+		Replayer    replayer(header);
+
+		TraceRecord stagger;
+		stagger.type = TraceRecord::Type::kStagger;
+		stagger.target = { 45.0f, 20.0f, 0.0f };
+		stagger.value = 25.0f;
+		stagger.tier = StaggerTier::kDefender;
+		CHECK(replayer.feed(stagger));
+
+		// the tier is recomputed from the scores, not taken from the recorded reprisal.
+		stagger.tier = StaggerTier::kAttacker;
+		CHECK(!replayer.feed(stagger));
+		stagger.tier = StaggerTier::kDefender;
+		stagger.value = 5.0f;
+		CHECK(!replayer.feed(stagger));
+	}
+}
+
+int main()
+{
+	testActorStateTable();
+	testActorStateTableClearExpired();
+	testActorStateTableSeqlock();
+	testPendingParries();
+	testSuppressedContacts();
+	testCanParry();
+	testStaggerTier();
+	testReplayConfig();
+	testReplayGap();
+	testReplayStagger();
+	if (failures != 0) {
+		std::fprintf(stderr, "%d check(s) failed\n", failures);
+		return 1;
+	}
+	std::printf("all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,470 @@
+/*Microbenchmarks of the parry hot paths, run outside the game against a mock world.
+Usage: ParryBench [iterations]
+Each case runs with 1, 4, 16 and 64 actors and reports the mean time per operation, so optimizations to these
+paths can be measured instead of guessed. The mock world only holds what the core reads: poses, score inputs
+and native handles. The contention cases read the parry timers from 1 to 8 threads while a writer updates them.*/
+#include "ParryCore/ActorStateTable.h"
+#include "ParryCore/MPSCQueue.h"
+#include "ParryCore/ParryCore.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	using namespace ParryCore;
+
+	std::size_t iterations = 1'000'000;
+
+	volatile double sink = 0.0;  // keeps the measured work from being optimized away.
+
+	/*Mean nanoseconds per call of a_fn(i), i running over the iterations.*/
+	template <class Fn>
+	double measure(Fn&& a_fn)
+	{
+		double accumulated = 0.0;
+		auto   start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < iterations; ++i) {
+			accumulated += static_cast<double>(a_fn(i));
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		sink = sink + accumulated;
+		return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+	}
+
+	void report(std::string_view a_case, std::size_t a_actors, double a_nsPerOp)
+	{
+		std::printf("%-40.*s %6zu %10.2f\n", static_cast<int>(a_case.size()), a_case.data(), a_actors, a_nsPerOp);
+	}
+
+	/*Stand-in for the actors of a cell: what the core reads from RE::Actor, filled with plausible values.*/
+	struct MockWorld
+	{
+		struct Actor
+		{
+			ActorStateTable::Key handle;
+			Pose                 pose;
+			ScoreInputs          inputs;
+			bool                 powerAttacking;
+		};
+
+		explicit MockWorld(std::size_t a_count)
+		{
+			std::mt19937                          rng(static_cast<std::uint32_t>(a_count));
+			std::uniform_real_distribution<float> coord(-2000.0f, 2000.0f);
+			std::uniform_real_distribution<float> yaw(0.0f, 6.2831853f);
+			std::uniform_real_distribution<float> score(-20.0f, 50.0f);
+			std::uniform_int_distribution<int>    coin(0, 1);
+			for (std::size_t i = 0; i < a_count; ++i) {
+				Actor actor;
+				// native handles are index | age << 20; spread them like the game does.
+				actor.handle = static_cast<ActorStateTable::Key>((i + 1) | (static_cast<std::uint32_t>(i % 7 + 1) << 20));
+				actor.pose = { { coord(rng), coord(rng), coord(rng) * 0.01f }, yaw(rng) };
+				actor.inputs.shield = coin(rng) != 0;
+				actor.inputs.weaponScore = score(rng);
+				actor.inputs.skillLevel = static_cast<double>(std::uniform_int_distribution<int>(15, 100)(rng));
+				actor.inputs.raceScore = score(rng) * 0.3f;
+				actor.inputs.female = coin(rng) != 0;
+				actor.inputs.player = i == 0;
+				actor.powerAttacking = coin(rng) != 0;
+				actors.push_back(actor);
+			}
+		}
+
+		const Actor& at(std::size_t a_i) const { return actors[a_i % actors.size()]; }
+		/*Some other actor than at(a_i), when there is one.*/
+		const Actor& opponentOf(std::size_t a_i) const { return actors[(a_i + 1) % actors.size()]; }
+
+		std::vector<Actor> actors;
+	};
+
+	/*Game strings are interned in a pool, so the anim event sink matches tags by pointer. Same here.*/
+	class StringPool
+	{
+	public:
+		const char* intern(std::string_view a_string) { return _strings.emplace(a_string).first->c_str(); }
+
+	private:
+		std::unordered_set<std::string> _strings;
+	};
+
+	/*Animation graph event sinks as the hook sees them: an object whose first word is its vtable.*/
+	using ProcessEventFn = double (*)(const void* a_sink, const char* a_tag);
+
+	struct MockVtable
+	{
+		ProcessEventFn processEvent;
+	};
+
+	struct MockSink
+	{
+		MockVtable* vtable;
+	};
+
+	/*The game's own ProcessEvent of one sink class.*/
+	template <int Class>
+	double originalProcessEvent(const void*, const char* a_tag)
+	{
+		return static_cast<double>(a_tag[0] + Class);
+	}
+
+	/*The hook before per-vtable thunks: one shared function looking the original up by vtable on every event.*/
+	std::unordered_map<std::uint64_t, ProcessEventFn> fnHash;
+
+	double mapProcessEvent(const void* a_sink, const char* a_tag)
+	{
+		return fnHash.at(reinterpret_cast<std::uint64_t>(static_cast<const MockSink*>(a_sink)->vtable))(a_sink, a_tag);
+	}
+
+	/*The hook as animEventHandler::ProcessEventHook installs it: the original in a static slot per hooked class.*/
+	template <int Class>
+	struct ProcessEventHook
+	{
+		static double thunk(const void* a_sink, const char* a_tag) { return func(a_sink, a_tag); }
+
+		static inline ProcessEventFn func;
+	};
+
+	/*The parry timers before the lock-free table: a map behind a shared_mutex, walked under the unique lock every frame.*/
+	class SharedMutexTimers
+	{
+	public:
+		void start(ActorStateTable::Key a_key)
+		{
+			std::unique_lock lock(_lock);
+			_timers[a_key] = 0.0f;
+		}
+
+		bool inParryState(ActorStateTable::Key a_key, const ParryWindow& a_window) const
+		{
+			std::shared_lock lock(_lock);
+			auto it = _timers.find(a_key);
+			return it != _timers.end() && a_window.contains(it->second);
+		}
+
+		void update(float a_delta, const ParryWindow& a_window)
+		{
+			std::unique_lock lock(_lock);
+			for (auto it = _timers.begin(); it != _timers.end();) {
+				it->second += a_delta;
+				it = it->second > a_window.end ? _timers.erase(it) : std::next(it);
+			}
+		}
+
+	private:
+		mutable std::shared_mutex                        _lock;
+		std::unordered_map<ActorStateTable::Key, float> _timers;
+	};
+
+	/*Mean nanoseconds per read of a_read(i), over a_readers threads reading while a writer keeps starting parries
+	and running frame updates, as hooks do while the main thread and anim events write.*/
+	template <class Read, class Write>
+	double measureContended(std::size_t a_readers, Read&& a_read, Write&& a_write)
+	{
+		std::atomic<bool>         stop{ false };
+		std::atomic<std::size_t>  ready{ 0 };
+		std::vector<double>       nsPerRead(a_readers);
+		std::vector<std::jthread> readers;
+		std::jthread              writer([&] {
+			for (std::size_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+				a_write(i);
+			}
+		});
+		for (std::size_t r = 0; r < a_readers; ++r) {
+			readers.emplace_back([&, r] {
+				ready.fetch_add(1);
+				while (ready.load() != a_readers) {}
+				double accumulated = 0.0;
+				auto   start = std::chrono::steady_clock::now();
+				for (std::size_t i = 0; i < iterations; ++i) {
+					accumulated += a_read(i * (r + 1)) ? 1.0 : 0.0;
+				}
+				auto elapsed = std::chrono::steady_clock::now() - start;
+				sink = sink + accumulated;
+				nsPerRead[r] = std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(iterations);
+			});
+		}
+		readers.clear();
+		stop = true;
+		double total = 0.0;
+		for (double ns : nsPerRead) {
+			total += ns;
+		}
+		return total / static_cast<double>(a_readers);
+	}
+
+	/*Hit-path reads of the parry timers while they are written, lock-free table against the former shared_mutex map.*/
+	void benchContention(const MockWorld& a_world)
+	{
+		const ParryWindow window;
+		for (std::size_t readers : { 1, 2, 4, 8 }) {
+			const auto suffix = " (" + std::to_string(readers) + " readers)";
+
+			SharedMutexTimers timers;
+			double            ns = measureContended(
+				readers, [&](std::size_t i) { return timers.inParryState(a_world.at(i).handle, window); },
+				[&](std::size_t i) {
+					timers.start(a_world.at(i).handle);
+					if (i % a_world.actors.size() == 0) {
+						timers.update(0.016f, window);
+					}
+				});
+			report("shared_mutex timer read" + suffix, a_world.actors.size(), ns);
+
+			ActorStateTable  table;
+			std::atomic<int> frame{ 0 };
+			ns = measureContended(
+				readers, [&](std::size_t i) {
+					ActorState state;
+					double     now = frame.load(std::memory_order_relaxed) * 0.016;
+					return table.find(a_world.at(i).handle, state) && state.has(ActorState::kTimingParry) && window.contains(now - state.parryStart);
+				},
+				[&](std::size_t i) {
+					double now = frame.load(std::memory_order_relaxed) * 0.016;
+					table.modify(a_world.at(i).handle, [now](ActorState& a_state) {
+						a_state.parryStart = now;
+						a_state.set(ActorState::kTimingParry);
+					}, now - window.end);
+					if (i % a_world.actors.size() == 0) {
+						frame.fetch_add(1, std::memory_order_relaxed);
+					}
+				});
+			report("lock-free table read" + suffix, a_world.actors.size(), ns);
+		}
+	}
+
+	void benchScores(const MockWorld& a_world)
+	{
+		const ScoreWeights weights;
+		const auto         actors = a_world.actors.size();
+		report("staticScore", actors, measure([&](std::size_t i) {
+			return staticScore(a_world.at(i).inputs, weights);
+		}));
+		report("GetScore", actors, measure([&](std::size_t i) {
+			const auto& actor = a_world.at(i);
+			return attackScore(staticScore(actor.inputs, weights), actor.powerAttacking, weights);
+		}));
+
+		// GetScore as the plugin runs it: the static part cached in the actor state table.
+		ActorStateTable table;
+		for (const auto& actor : a_world.actors) {
+			table.modify(actor.handle, [&](ActorState& a_state) {
+				a_state.staticScore = static_cast<float>(staticScore(actor.inputs, weights));
+				a_state.set(ActorState::kScoreCached);
+			}, 0.0);
+		}
+		auto cachedScore = [&](const MockWorld::Actor& a_actor) {
+			ActorState state;
+			table.find(a_actor.handle, state);
+			return attackScore(state.staticScore, a_actor.powerAttacking, weights);
+		};
+		report("GetScore (cached)", actors, measure([&](std::size_t i) {
+			return cachedScore(a_world.at(i));
+		}));
+		report("AttackerBeatsParry", actors, measure([&](std::size_t i) {
+			return static_cast<double>(staggerTier(cachedScore(a_world.at(i)) - cachedScore(a_world.opponentOf(i))));
+		}));
+	}
+
+	void benchParryTimer(const MockWorld& a_world)
+	{
+		const auto      actors = a_world.actors.size();
+		const ParryWindow window;
+		ActorStateTable table;
+		double          now = 0.0;
+		report("parry timer start", actors, measure([&](std::size_t i) {
+			now += 1e-6;
+			return table.modify(a_world.at(i).handle, [now](ActorState& a_state) {
+				a_state.parryStart = now;
+				a_state.set(ActorState::kTimingParry);
+			}, now - window.end) ? 1.0 : 0.0;
+		}));
+		report("parry timer query", actors, measure([&](std::size_t i) {
+			ActorState state;
+			return table.find(a_world.at(i).handle, state) ? now - state.parryStart : 0.0;
+		}));
+		report("parry timer update", actors, measure([&](std::size_t i) {
+			return static_cast<double>(table.modify(a_world.at(i).handle, [](ActorState& a_state) {
+				a_state.parryCost += 1.0f;
+				a_state.set(ActorState::kParryCostCached);
+			}, 0.0));
+		}));
+		report("parry timer finish", actors, measure([&](std::size_t i) {
+			float due = 0.0f;
+			table.modify(a_world.at(i).handle, [&due](ActorState& a_state) {
+				due = finishBash(a_state, true);
+			}, 0.0);
+			return due;
+		}));
+	}
+
+	void benchGeometry(const MockWorld& a_world)
+	{
+		const auto        actors = a_world.actors.size();
+		const ParryWindow window;
+		report("inBlockAngle", actors, measure([&](std::size_t i) {
+			return inBlockAngle(a_world.at(i).pose, a_world.opponentOf(i).pose.position, 35.0f) ? 1.0 : 0.0;
+		}));
+		ActorState timing;
+		timing.parryStart = 0.0;
+		timing.set(ActorState::kTimingParry);
+		report("canParry", actors, measure([&](std::size_t i) {
+			return canParry(&timing, 0.1, window, a_world.at(i).pose, a_world.opponentOf(i).pose.position, 35.0f) ? 1.0 : 0.0;
+		}));
+		report("PredictAimProjectile", actors, measure([&](std::size_t i) {
+			const auto& shooter = a_world.at(i);
+			const auto& target = a_world.opponentOf(i);
+			Vec3        velocity{ 0.0f, 3000.0f, 0.0f };
+			predictAim(shooter.pose.position, target.pose.position, { 100.0f, 50.0f, 0.0f }, 690.0f, velocity);
+			return velocity.x;
+		}));
+	}
+
+	void benchTagDispatch(const MockWorld& a_world)
+	{
+		// the routes of animEventHandler, and a mix of the tags a crowded cell sends.
+		StringPool pool;
+		const std::array routes{ pool.intern("blockStop"), pool.intern("bashStop") };
+		const std::array tags{
+			pool.intern("weaponSwing"), pool.intern("FootLeft"), pool.intern("FootRight"), pool.intern("blockStop"),
+			pool.intern("SoundPlay"), pool.intern("HitFrame"), pool.intern("bashStop"), pool.intern("tailCombatIdle"),
+		};
+		std::vector<std::size_t> handled(a_world.actors.size());
+		report("anim event dispatch", a_world.actors.size(), measure([&](std::size_t i) {
+			const char* tag = tags[i % tags.size()];
+			for (std::size_t route = 0; route < routes.size(); ++route) {
+				if (tag == routes[route]) {
+					++handled[i % handled.size()];
+					return 1.0;
+				}
+			}
+			return 0.0;
+		}));
+	}
+
+	/*A hot path message as HotLog formats it on the calling thread.*/
+	struct LogEntry
+	{
+		int           level{ 2 };
+		std::uint16_t length{ 0 };
+		char          text[240];
+	};
+
+	/*Cost of logging the parrier on every parry check of a hit: compiled out, formatted into a ring drained by a
+	writer thread as HotLog does, and written and flushed synchronously as logger::info with flush_on(info) did.*/
+	void benchHitLogging(const MockWorld& a_world)
+	{
+		static constexpr std::array names{ "Prisoner", "Bandit Marauder", "Whiterun Guard", "Draugr Deathlord" };
+
+		const auto        actors = a_world.actors.size();
+		const ParryWindow window;
+		ActorState        timing;
+		timing.parryStart = 0.0;
+		timing.set(ActorState::kTimingParry);
+		auto check = [&](std::size_t i) {
+			return canParry(&timing, 0.1, window, a_world.at(i).pose, a_world.opponentOf(i).pose.position, 35.0f) ? 1.0 : 0.0;
+		};
+		report("hit, logging compiled out", actors, measure(check));
+
+		std::FILE* file = std::tmpfile();
+		if (!file) {
+			return;
+		}
+		{
+			MPSCQueue<LogEntry, 512>   queue;
+			std::atomic<std::uint64_t> dropped{ 0 };
+			std::jthread               writer([&](std::stop_token a_stop) {
+				LogEntry entry;
+				while (!a_stop.stop_requested()) {
+					if (!queue.pop(entry)) {
+						std::this_thread::yield();
+						continue;
+					}
+					std::fwrite(entry.text, 1, entry.length, file);
+				}
+			});
+			report("hit, ring log", actors, measure([&](std::size_t i) {
+				LogEntry entry;
+				// snprintf in place of HotLog's std::format_to_n, which not every compiler of the core ships yet; both are bounded and don't allocate.
+				auto     length = std::snprintf(entry.text, sizeof(entry.text), "canParry: %s", names[i % names.size()]);
+				entry.length = static_cast<std::uint16_t>((std::min)(static_cast<std::size_t>((std::max)(length, 0)), sizeof(entry.text) - 1));
+				if (!queue.push(entry)) {
+					dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+				return check(i);
+			}));
+			std::printf("  (%llu of %zu ring messages dropped)\n", static_cast<unsigned long long>(dropped.load()), iterations);
+		}
+		report("hit, synchronous log", actors, measure([&](std::size_t i) {
+			std::fprintf(file, "canParry: %s\n", names[i % names.size()]);
+			std::fflush(file);
+			return check(i);
+		}));
+		std::fclose(file);
+	}
+
+	/*Cost of getting an event through the hooked ProcessEvent, for the player's and the NPCs' sink classes.*/
+	void benchHookDispatch(const MockWorld& a_world)
+	{
+		StringPool  pool;
+		const char* tag = pool.intern("weaponSwing");
+		MockVtable  player{ originalProcessEvent<0> };
+		MockVtable  character{ originalProcessEvent<1> };
+		std::vector<MockSink> sinks;
+		for (std::size_t i = 0; i < a_world.actors.size(); ++i) {
+			sinks.push_back({ a_world.at(i).inputs.player ? &player : &character });
+		}
+		auto dispatch = [&](std::size_t i) {
+			const auto& sink = sinks[i % sinks.size()];
+			return sink.vtable->processEvent(&sink, tag);
+		};
+
+		report("anim event hook (none)", sinks.size(), measure(dispatch));
+
+		fnHash[reinterpret_cast<std::uint64_t>(&player)] = player.processEvent;
+		fnHash[reinterpret_cast<std::uint64_t>(&character)] = character.processEvent;
+		player.processEvent = mapProcessEvent;
+		character.processEvent = mapProcessEvent;
+		report("anim event hook (vtable map)", sinks.size(), measure(dispatch));
+
+		player.processEvent = fnHash.at(reinterpret_cast<std::uint64_t>(&player));
+		character.processEvent = fnHash.at(reinterpret_cast<std::uint64_t>(&character));
+		fnHash.clear();
+		ProcessEventHook<0>::func = std::exchange(player.processEvent, ProcessEventHook<0>::thunk);
+		ProcessEventHook<1>::func = std::exchange(character.processEvent, ProcessEventHook<1>::thunk);
+		report("anim event hook (thunk)", sinks.size(), measure(dispatch));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 1) {
+		iterations = static_cast<std::size_t>((std::max)(1L, std::atol(argv[1])));
+	}
+	std::printf("%-40s %6s %10s\n", "case", "actors", "ns/op");
+	for (std::size_t actors : { 1, 4, 16, 64 }) {
+		MockWorld world(actors);
+		benchScores(world);
+		benchParryTimer(world);
+		benchGeometry(world);
+		benchTagDispatch(world);
+		benchHookDispatch(world);
+	}
+	benchHitLogging(MockWorld(64));
+	benchContention(MockWorld(64));
+	return 0;
+}
@@ -0,0 +1,62 @@
+/*Replay a combat trace recorded in game (EldenParry.trace) through the parry core.
+Usage: ParryReplay <trace file> [passes]
+Reports outcomes that differ from the recording, and replay throughput over the given number of passes.
+Exits with 1 if any outcome differs, so it can gate changes to the core.*/
+#include "ParryCore/Replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		std::fprintf(stderr, "Usage: %s <trace file> [passes]\n", argv[0]);
+		return 2;
+	}
+	const int passes = argc > 2 ? (std::max)(1, std::atoi(argv[2])) : 10;
+
+	ParryCore::TraceReader reader;
+	if (!reader.open(argv[1])) {
+		std::fprintf(stderr, "%s is not a valid trace.\n", argv[1]);
+		return 2;
+	}
+	const auto records = reader.readAll();
+	const auto& header = reader.header();
+	std::printf("%zu records (%llu written, capacity %u), window %.3f-%.3f s, block angle %.1f\n",
+		records.size(), static_cast<unsigned long long>(header.written), header.capacity,
+		header.window.start, header.window.end, header.blockAngle);
+
+	std::vector<double> passSeconds;
+	ParryCore::ReplayStats stats;
+	for (int pass = 0; pass < passes; ++pass) {
+		ParryCore::Replayer replayer(header);
+		auto start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < records.size(); ++i) {
+			if (!replayer.feed(records[i]) && pass == 0) {
+				const auto& record = records[i];
+				std::printf("mismatch at record %zu: type %u, actor %08X, other %08X, t=%.4f\n",
+					i, static_cast<unsigned>(record.type), record.actor, record.other, record.time);
+			}
+		}
+		passSeconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+		if (pass == 0) {
+			stats = replayer.stats();
+		}
+	}
+
+	std::ranges::sort(passSeconds);
+	const double median = passSeconds[passSeconds.size() / 2];
+	std::printf("%llu decisions, %llu parried, %llu skipped (bash started before the trace or a gap), %llu gaps, %llu mismatches\n",
+		static_cast<unsigned long long>(stats.decisions), static_cast<unsigned long long>(stats.parries),
+		static_cast<unsigned long long>(stats.skipped), static_cast<unsigned long long>(stats.gaps),
+		static_cast<unsigned long long>(stats.mismatches));
+	if (!records.empty() && median > 0.0) {
+		std::printf("%d passes: median %.3f ms, best %.3f ms, %.1f ns/record, %.2f M records/s\n",
+			passes, median * 1e3, passSeconds.front() * 1e3,
+			median * 1e9 / static_cast<double>(records.size()), static_cast<double>(records.size()) / median / 1e6);
+	}
+	return stats.mismatches ? 1 : 0;
+}
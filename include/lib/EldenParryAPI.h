@@ -0,0 +1,143 @@
+#pragma once
+#include <functional>
+#include <stdint.h>
+/*
+* For modders: Copy this file into your own project if you wish to use this API
+*/
+namespace EP_API
+{
+	constexpr const auto EldenParryPluginName = "EldenParry";
+
+	// Available Elden Parry interface versions
+	enum class InterfaceVersion : uint8_t
+	{
+		V1,
+		V2
+	};
+
+	// Error types that may be returned by Elden Parry
+	enum class APIResult : uint8_t
+	{
+		// Your API call was successful
+		OK,
+
+		// A callback from this plugin has already been registered
+		AlreadyRegistered,
+
+		// A callback from this plugin has not been registered
+		NotRegistered,
+	};
+
+	struct ParryEventData
+	{
+		enum class Type : uint8_t
+		{
+			Melee,
+			Projectile
+		};
+
+		Type type;
+		// the actor who parried
+		RE::Actor* parrier;
+		// the actor whose attack was parried; for projectiles, the shooter if it is an actor, otherwise nullptr
+		RE::Actor* attacker;
+		// the parried projectile; nullptr for melee parries
+		RE::Projectile* projectile;
+		// riposte scores of the attacker and the parrier, as GetRiposteScore returns them on the thread the parry is reported from; 0 if there is no attacker
+		double attackerScore;
+		double parrierScore;
+	};
+
+	using ParryCallback = std::function<void(const ParryEventData&)>;
+
+	// Who staggers after a parry, and how hard
+	enum class StaggerTier : uint8_t
+	{
+		// the parrier is overpowered and staggers hard
+		DefenderLarge,
+		// the parrier is overpowered and staggers
+		Defender,
+		// the attacker staggers
+		Attacker,
+		// the attacker staggers hard
+		AttackerLarge
+	};
+
+	// Elden Parry's modder interface
+	class IVEldenParry1
+	{
+	public:
+		/// <summary>
+		/// Adds a callback that will run after a successful parry, right after Elden Parry resolved it.
+		/// Melee parries are resolved on the main thread, projectile parries may be resolved on a havok thread, so be brief.
+		/// </summary>
+		/// <param name="a_myPluginHandle">Your assigned plugin handle</param>
+		/// <param name="a_parryCallback">The callback function</param>
+		/// <returns>OK, AlreadyRegistered</returns>
+		virtual APIResult AddParryCallback(SKSE::PluginHandle a_myPluginHandle, ParryCallback&& a_parryCallback) noexcept = 0;
+
+		/// <summary>
+		/// Removes the callback added by your plugin.
+		/// </summary>
+		/// <param name="a_myPluginHandle">Your assigned plugin handle</param>
+		/// <returns>OK, NotRegistered</returns>
+		virtual APIResult RemoveParryCallback(SKSE::PluginHandle a_myPluginHandle) noexcept = 0;
+	};
+
+	// Elden Parry's modder interface, with read-only queries of the parry state.
+	// The parry window queries don't take locks and may be called from any thread.
+	// The score queries compute and cache missing scores on the main thread only; from other threads they only read the cache.
+	class IVEldenParry2 : public IVEldenParry1
+	{
+	public:
+		/// <summary>
+		/// Is the actor in its parry window, i.e. would a hit landing now be parried if it comes from within the block angle?
+		/// </summary>
+		/// <param name="a_actor">The actor to query</param>
+		/// <returns>True if the actor is in its parry window</returns>
+		virtual bool IsInParryWindow(RE::Actor* a_actor) const noexcept = 0;
+
+		/// <summary>
+		/// Time left in the actor's parry window, in the clock configured for the parry window (real or game time).
+		/// </summary>
+		/// <param name="a_actor">The actor to query</param>
+		/// <returns>Seconds left, or 0 if the actor is not in its parry window</returns>
+		virtual float GetParryWindowRemaining(RE::Actor* a_actor) const noexcept = 0;
+
+		/// <summary>
+		/// Get the actor's riposte score, including the power attack bonus if it is power attacking.
+		/// The score is cached by Elden Parry. Called from the main thread, a missing score is computed and cached;
+		/// called from any other thread, only a cached score is returned, and 0 if there is none.
+		/// </summary>
+		/// <param name="a_actor">The actor to query</param>
+		/// <returns>The riposte score</returns>
+		virtual double GetRiposteScore(RE::Actor* a_actor) noexcept = 0;
+
+		/// <summary>
+		/// Predict who would stagger if the parrier parried the attacker now.
+		/// Uses the riposte scores as GetRiposteScore does, so call it from the main thread for an exact answer.
+		/// </summary>
+		/// <param name="a_parrier">The parrying actor</param>
+		/// <param name="a_attacker">The attacking actor</param>
+		/// <returns>The stagger tier Elden Parry would apply</returns>
+		virtual StaggerTier PredictStaggerTier(RE::Actor* a_parrier, RE::Actor* a_attacker) noexcept = 0;
+	};
+
+	typedef void* (*_RequestPluginAPI)(const InterfaceVersion interfaceVersion);
+
+	/// <summary>
+	/// Request the Elden Parry API interface.
+	/// Recommended: Send your request during or after SKSEMessagingInterface::kMessage_PostLoad to make sure the dll has already been loaded
+	/// </summary>
+	/// <param name="a_interfaceVersion">The interface version to request</param>
+	/// <returns>The pointer to the API singleton, or nullptr if request failed</returns>
+	[[nodiscard]] inline void* RequestPluginAPI(const InterfaceVersion a_interfaceVersion = InterfaceVersion::V1)
+	{
+		auto pluginHandle = GetModuleHandle(L"EldenParry.dll");
+		_RequestPluginAPI requestAPIFunction = (_RequestPluginAPI)GetProcAddress(pluginHandle, "RequestPluginAPI");
+		if (requestAPIFunction) {
+			return requestAPIFunction(a_interfaceVersion);
+		}
+		return nullptr;
+	}
+}
@@ -0,0 +1,53 @@
+#include "ActorEventHandler.h"
+#include "EldenParry.h"
+
+void actorEventHandler::Register()
+{
+	auto eventSourceHolder = RE::ScriptEventSourceHolder::GetSingleton();
+	eventSourceHolder->AddEventSink<RE::TESCellAttachDetachEvent>(GetSingleton());
+	eventSourceHolder->AddEventSink<RE::TESDeathEvent>(GetSingleton());
+	eventSourceHolder->AddEventSink<RE::TESEquipEvent>(GetSingleton());
+	eventSourceHolder->AddEventSink<RE::TESSwitchRaceCompleteEvent>(GetSingleton());
+	RE::SkillIncrease::GetEventSource()->AddEventSink(GetSingleton());
+	logger::info("Registered actor event sinks.");
+}
+
+EventResult actorEventHandler::ProcessEvent(const RE::TESCellAttachDetachEvent* a_event, RE::BSTEventSource<RE::TESCellAttachDetachEvent>*)
+{
+	if (a_event && !a_event->attached && a_event->reference && a_event->reference->Is(RE::FormType::ActorCharacter)) {
+		EldenParry::GetSingleton()->purge(a_event->reference.get());
+	}
+	return EventResult::kContinue;
+}
+
+EventResult actorEventHandler::ProcessEvent(const RE::TESDeathEvent* a_event, RE::BSTEventSource<RE::TESDeathEvent>*)
+{
+	if (a_event && a_event->actorDying) {
+		EldenParry::GetSingleton()->purge(a_event->actorDying.get());
+	}
+	return EventResult::kContinue;
+}
+
+EventResult actorEventHandler::ProcessEvent(const RE::TESEquipEvent* a_event, RE::BSTEventSource<RE::TESEquipEvent>*)
+{
+	if (a_event && a_event->actor) {
+		EldenParry::GetSingleton()->invalidateScore(a_event->actor.get());
+	}
+	return EventResult::kContinue;
+}
+
+EventResult actorEventHandler::ProcessEvent(const RE::TESSwitchRaceCompleteEvent* a_event, RE::BSTEventSource<RE::TESSwitchRaceCompleteEvent>*)
+{
+	if (a_event && a_event->subject) {
+		EldenParry::GetSingleton()->invalidateScore(a_event->subject.get());
+	}
+	return EventResult::kContinue;
+}
+
+EventResult actorEventHandler::ProcessEvent(const RE::SkillIncrease::Event* a_event, RE::BSTEventSource<RE::SkillIncrease::Event>*)
+{
+	if (a_event && a_event->player) {
+		EldenParry::GetSingleton()->invalidateScore(a_event->player);
+	}
+	return EventResult::kContinue;
+}
@@ -0,0 +1,29 @@
+#pragma once
+using EventResult = RE::BSEventNotifyControl;
+/*Keeps EldenParry's per-actor state in sync with the actor: state is dropped when the actor goes away,
+and its cached riposte score is invalidated when its equipment, skills or race change.*/
+class actorEventHandler :
+	public RE::BSTEventSink<RE::TESCellAttachDetachEvent>,
+	public RE::BSTEventSink<RE::TESDeathEvent>,
+	public RE::BSTEventSink<RE::TESEquipEvent>,
+	public RE::BSTEventSink<RE::TESSwitchRaceCompleteEvent>,
+	public RE::BSTEventSink<RE::SkillIncrease::Event>
+{
+public:
+	static actorEventHandler* GetSingleton()
+	{
+		static actorEventHandler singleton;
+		return std::addressof(singleton);
+	}
+
+	static void Register();
+
+	EventResult ProcessEvent(const RE::TESCellAttachDetachEvent* a_event, RE::BSTEventSource<RE::TESCellAttachDetachEvent>* a_eventSource) override;
+	EventResult ProcessEvent(const RE::TESDeathEvent* a_event, RE::BSTEventSource<RE::TESDeathEvent>* a_eventSource) override;
+	EventResult ProcessEvent(const RE::TESEquipEvent* a_event, RE::BSTEventSource<RE::TESEquipEvent>* a_eventSource) override;
+	EventResult ProcessEvent(const RE::TESSwitchRaceCompleteEvent* a_event, RE::BSTEventSource<RE::TESSwitchRaceCompleteEvent>* a_eventSource) override;
+	EventResult ProcessEvent(const RE::SkillIncrease::Event* a_event, RE::BSTEventSource<RE::SkillIncrease::Event>* a_eventSource) override;
+
+private:
+	actorEventHandler() = default;
+};
@@ -1,45 +1,59 @@
 #include "AnimEventHandler.h"
 #include "EldenParry.h"
+#include "LatencyStats.h"
 #include "Settings.h"
-constexpr uint32_t hash(const char* data, size_t const size) noexcept
+
+namespace
 {
-	uint32_t hash = 5381;
+	void onBlockStop(RE::Actor* a_actor)
+	{
+		if (a_actor->AsActorState()->GetAttackState() == RE::ATTACK_STATE_ENUM::kBash) {
+			EldenParry::GetSingleton()->startTimingParry(a_actor);
+		}
+	}
 
-	for (const char* c = data; c < data + size; ++c) {
-		hash = ((hash << 5) + hash) + (unsigned char)*c;
+	void onBashStop(RE::Actor* a_actor)
+	{
+		EldenParry::GetSingleton()->finishBash(a_actor);
 	}
 
-	return hash;
+	struct EventRoute
+	{
+		std::string_view tag;
+		void (*handler)(RE::Actor*);
+	};
+
+	/*Animation events EldenParry listens to. To subscribe to another event, add a route here.*/
+	constexpr std::array eventRoutes{
+		EventRoute{ "blockStop"sv, onBlockStop },
+		EventRoute{ "bashStop"sv, onBashStop },
+	};
+
+	/*Tags are interned in the game's string pool, so an event's tag matches a route iff the pointers are equal.*/
+	std::array<RE::BSFixedString, eventRoutes.size()> internedTags;
 }
 
-constexpr uint32_t operator"" _h(const char* str, size_t size) noexcept
+void animEventHandler::InternEventTags()
 {
-	return hash(str, size);
+	for (std::size_t i = 0; i < eventRoutes.size(); ++i) {
+		internedTags[i] = RE::BSFixedString(eventRoutes[i].tag);
+	}
 }
 
-RE::BSEventNotifyControl animEventHandler::HookedProcessEvent(RE::BSAnimationGraphEvent& a_event, RE::BSTEventSource<RE::BSAnimationGraphEvent>* src)
+void animEventHandler::ProcessAnimEvent(const RE::BSAnimationGraphEvent* a_event)
 {
-	FnProcessEvent fn = fnHash.at(*(uint64_t*)this);
-	//RE::ConsoleLog::GetSingleton()->Print(a_event.tag.c_str());
-	if (!a_event.holder) {
-		return fn ? (this->*fn)(a_event, src) : RE::BSEventNotifyControl::kContinue;
+	//RE::ConsoleLog::GetSingleton()->Print(a_event->tag.c_str());
+	LatencyScope latency(LatencyProbe::kAnimEvent);
+	if (!a_event->holder) {
+		return;
 	}
-	std::string_view eventTag = a_event.tag.data();
-	switch (hash(eventTag.data(), eventTag.size())) {
-	case "blockStop"_h:
-		if (const_cast<RE::TESObjectREFR*>(a_event.holder)->As<RE::Actor>()->AsActorState()->GetAttackState() == RE::ATTACK_STATE_ENUM::kBash) {
-			EldenParry::GetSingleton()->startTimingParry((RE::Actor*)(a_event.holder));
+	const char* tag = a_event->tag.data();
+	for (std::size_t i = 0; i < eventRoutes.size(); ++i) {
+		if (tag == internedTags[i].data()) {
+			if (auto actor = const_cast<RE::TESObjectREFR*>(a_event->holder)->As<RE::Actor>()) {
+				eventRoutes[i].handler(actor);
+			}
+			return;
 		}
-		break;
-	case "bashStop"_h:
-		auto EP = EldenParry::GetSingleton();
-		if (Settings::bSuccessfulParryNoCost) {
-			EP->applyParryCost((RE::Actor*)a_event.holder);
-		}
-		EP->finishTimingParry((RE::Actor*)a_event.holder);
-		break;
 	}
-	return fn ? (this->*fn)(a_event, src) : RE::BSEventNotifyControl::kContinue;
 }
-
-std::unordered_map<uint64_t, animEventHandler::FnProcessEvent> animEventHandler::fnHash;
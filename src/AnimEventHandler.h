@@ -2,47 +2,51 @@
 using EventResult = RE::BSEventNotifyControl;
 class animEventHandler
 {
+	friend class ParryBenchmark;
+
 private:
-	template <class Ty>
-	static Ty SafeWrite64Function(uintptr_t addr, Ty data)
-	{
-		DWORD oldProtect;
-		void* _d[2];
-		memcpy(_d, &data, sizeof(data));
-		size_t len = sizeof(_d[0]);
+	/*Resolve the tags of all routed events to the game's interned strings.*/
+	static void InternEventTags();
 
-		VirtualProtect((void*)addr, len, PAGE_EXECUTE_READWRITE, &oldProtect);
-		Ty olddata;
-		memset(&olddata, 0, sizeof(Ty));
-		memcpy(&olddata, (void*)addr, len);
-		memcpy((void*)addr, &_d[0], len);
-		VirtualProtect((void*)addr, len, oldProtect, &oldProtect);
-		return olddata;
-	}
+	/*Handle an animation graph event before it reaches the game's own sink.*/
+	static void ProcessAnimEvent(const RE::BSAnimationGraphEvent* a_event);
 
-	typedef RE::BSEventNotifyControl (animEventHandler::*FnProcessEvent)(RE::BSAnimationGraphEvent& a_event, RE::BSTEventSource<RE::BSAnimationGraphEvent>* dispatcher);
+	/*Hook of BSTEventSink<BSAnimationGraphEvent>::ProcessEvent in the vtable of T.
+	Each instantiation keeps its own original function, so dispatch is a single indirect call.*/
+	template <class T>
+	class ProcessEventHook
+	{
+	public:
+		static void install()
+		{
+			REL::Relocation<std::uintptr_t> vtbl{ T::VTABLE[2] };
+			func = vtbl.write_vfunc(0x1, thunk);
+		}
 
-	RE::BSEventNotifyControl HookedProcessEvent(RE::BSAnimationGraphEvent& a_event, RE::BSTEventSource<RE::BSAnimationGraphEvent>* src);
+	private:
+		static EventResult thunk(RE::BSTEventSink<RE::BSAnimationGraphEvent>* a_sink, const RE::BSAnimationGraphEvent* a_event, RE::BSTEventSource<RE::BSAnimationGraphEvent>* a_src)
+		{
+			if (a_event) {
+				ProcessAnimEvent(a_event);
+			}
+			return func(a_sink, a_event, a_src);
+		}
 
-	static void HookSink(uintptr_t ptr)
-	{
-		FnProcessEvent fn = SafeWrite64Function(ptr + 0x8, &animEventHandler::HookedProcessEvent);
-		fnHash.insert(std::pair<uint64_t, FnProcessEvent>(ptr, fn));
-	}
+		static inline REL::Relocation<decltype(thunk)> func;
+	};
 
 public:
 	/*Hook anim event sink*/
 	static void Register(bool player, bool NPC)
 	{
+		InternEventTags();
 		if (player) {
 			logger::info("Sinking animation event hook for player");
-			REL::Relocation<uintptr_t> pcPtr{ RE::VTABLE_PlayerCharacter[2] };
-			HookSink(pcPtr.address());
+			ProcessEventHook<RE::PlayerCharacter>::install();
 		}
 		if (NPC) {
 			logger::info("Sinking animation event hook for NPC");
-			REL::Relocation<uintptr_t> npcPtr{ RE::VTABLE_Character[2] };
-			HookSink(npcPtr.address());
+			ProcessEventHook<RE::Character>::install();
 		}
 		logger::info("Sinking complete.");
 	}
@@ -51,7 +55,4 @@ public:
 	{
 		Register(true, false);
 	}
-
-protected:
-	static std::unordered_map<uint64_t, FnProcessEvent> fnHash;
 };
@@ -0,0 +1,38 @@
+#pragma once
+#include "EldenParry.h"
+#include "ParryCore/ParryCore.h"
+#include "Settings.h"
+
+/*Conversions from the game's types to the value types ParryCore works on.*/
+namespace CoreAdapter
+{
+	inline ParryCore::Vec3 toVec3(const RE::NiPoint3& a_point)
+	{
+		return { a_point.x, a_point.y, a_point.z };
+	}
+
+	inline RE::NiPoint3 toNiPoint3(const ParryCore::Vec3& a_vec)
+	{
+		return { a_vec.x, a_vec.y, a_vec.z };
+	}
+
+	inline ParryCore::Pose poseOf(const RE::TESObjectREFR* a_refr)
+	{
+		return { toVec3(a_refr->GetPosition()), a_refr->GetAngleZ() };
+	}
+
+	inline ParryCore::ParryWindow parryWindow(const Settings::Config& a_settings)
+	{
+		return { a_settings.fParryWindow_Start, a_settings.fParryWindow_End };
+	}
+
+	inline ParryCore::ScoreWeights scoreWeights(const Milf::Scores& a_scores)
+	{
+		ParryCore::ScoreWeights weights;
+		weights.weaponSkillWeight = a_scores.weaponSkillWeight;
+		weights.femaleScore = a_scores.femaleScore;
+		weights.playerScore = a_scores.playerScore;
+		weights.powerAttackScore = a_scores.powerAttackScore;
+		return weights;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+#include "ParryCore/MPSCQueue.h"
+
+/*Cosmetic effect or Papyrus mod event to be delivered for an actor on the main thread.*/
+struct EffectRecord
+{
+	enum class Type : std::uint8_t
+	{
+		kParry,
+		kGuardBash,
+		kMeleeParryEvent,   // actor is the attacker.
+		kRangedParryEvent,  // actor is unused.
+	};
+
+	std::uint32_t actor{ 0 };  // native handle of the actor.
+	Type          type{ Type::kParry };
+};
+
+/*Hook threads push effect records, the main thread drains them once per frame.
+When the queue is full the record is dropped, which only costs a cosmetic effect or a mod event.*/
+using EffectQueue = MPSCQueue<EffectRecord, 256>;
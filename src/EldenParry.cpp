@@ -1,10 +1,29 @@
 #include "EldenParry.h"
+#include "CoreAdapter.h"
+#include "HotLog.h"
+#include "LatencyStats.h"
+#include "ModAPI.h"
+#include "NPCParryAI.h"
+#include "ParryClock.h"
+#include "ScoreTables.h"
 #include "Settings.h"
+#include "TraceRecorder.h"
 #include "Utils.hpp"
-using uniqueLocker = std::unique_lock<std::shared_mutex>;
-using sharedLocker = std::shared_lock<std::shared_mutex>;
+
+#include <fstream>
+
+namespace
+{
+	/*Parry windows started before the returned time have expired; their slots may be reclaimed.*/
+	double expiredBefore()
+	{
+		const auto& settings = Settings::get();
+		return ParryClock::now(settings.bUseRealTimeParryWindow) - settings.fParryWindow_End;
+	}
+}
 
 void EldenParry::init() {
+	_mainThread = std::this_thread::get_id();
 	logger::info("Obtaining precision API...");
 	_precision_API = reinterpret_cast<PRECISION_API::IVPrecision1*>(PRECISION_API::RequestPluginAPI());
 	if (_precision_API) {
@@ -14,6 +33,14 @@ void EldenParry::init() {
 			PRECISION_API::APIResult::OK) {
 			logger::info("Successfully registered precision API prehit callback.");
 		}
+		if (_precision_API->AddPrePhysicsStepCallback(SKSE::GetPluginHandle(), precisionPrePhysicsStepCallbackFunc) ==
+			PRECISION_API::APIResult::OK) {
+			logger::info("Successfully registered precision API pre-physics step callback.");
+		}
+		if (_precision_API->AddCollisionFilterComparisonCallback(SKSE::GetPluginHandle(), precisionCollisionFilterComparisonCallbackFunc) ==
+			PRECISION_API::APIResult::OK) {
+			logger::info("Successfully registered precision API collision filter comparison callback.");
+		}
 	} else {
 		logger::info("Precision API not found.");
 	}
@@ -38,49 +65,151 @@ void EldenParry::init() {
 	//read fcombatHitConeAngle
 	_GMST_fCombatHitConeAngle = RE::GameSettingCollection::GetSingleton()->GetSetting("fCombatHitConeAngle")->GetFloat();
 	_parryAngle = _GMST_fCombatHitConeAngle;
+
+	//intern the mod event names once, instead of on every parry
+	_meleeParryEventName = "EP_MeleeParryEvent";
+	_rangedParryEventName = "EP_RangedParryEvent";
+
+	TraceRecorder::GetSingleton()->start(_parryAngle);
 }
 
 void EldenParry::update() {
-	if (!_bUpdate) {
-		return;
+	LatencyScope latency(LatencyProbe::kUpdate);
+	static float* g_deltaTime = (float*)RELOCATION_ID(523660, 410199).address();          // 2F6B948
+	static float* g_deltaTimeRealTime = (float*)RELOCATION_ID(523661, 410200).address();  // 2F6B94C
+	ParryClock::update(*g_deltaTime);
+	_actorStates.clearExpired(expiredBefore());
+	sweepSuppressedContacts();
+	playQueuedEffects();
+	NPCParryAI::GetSingleton()->update();
+	Hitstop::GetSingleton()->update(*g_deltaTimeRealTime);
+	Settings::update();
+	LatencyStats::GetSingleton()->update();
+}
+
+void EldenParry::queueEffect(RE::Actor* a_actor, EffectRecord::Type a_type) {
+	if (!_effectQueue.push({ a_actor->GetHandle().native_handle(), a_type })) {
+		HOTLOG_WARN("Effect queue is full, dropping effect for {}", a_actor->GetName());
 	}
-	uniqueLocker lock(mtx_parryTimer);
-	auto it = _parryTimer.begin();
-	if (it == _parryTimer.end()) {
-		_bUpdate = false;
+}
+
+/// <summary>
+/// Play the effects and send the mod events queued by the hooks since the last frame, at most once per actor and type.
+/// At most a queue's worth of records is handled per frame; records pushed meanwhile wait for the next frame.
+/// </summary>
+void EldenParry::playQueuedEffects() {
+	EffectRecord record;
+	if (!_effectQueue.pop(record)) {
 		return;
 	}
-	while (it != _parryTimer.end()) {
-		if (!it->first) {
-			it = _parryTimer.erase(it);
+	// (actor, type) pairs played this frame, open addressing at half load at most, 0 marking a free slot.
+	std::array<std::uint64_t, EffectQueue::CAPACITY * 2> played{};
+	auto firstPlay = [&played](const EffectRecord& a_record) {
+		const std::uint64_t key = ((static_cast<std::uint64_t>(a_record.actor) << 8) | std::to_underlying(a_record.type)) + 1;
+		for (std::size_t idx = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (played.size() - 1);; idx = (idx + 1) & (played.size() - 1)) {
+			if (played[idx] == key) {
+				return false;
+			}
+			if (played[idx] == 0) {
+				played[idx] = key;
+				return true;
+			}
+		}
+	};
+	std::size_t drained = 0;
+	do {
+		if (!firstPlay(record)) {
 			continue;
 		}
-		if (it->second > Settings::fParryWindow_End) {
-			it = _parryTimer.erase(it);
+		if (record.type == EffectRecord::Type::kRangedParryEvent) {
+			sendModEvent(_rangedParryEventName, nullptr);
 			continue;
 		}
-		static float* g_deltaTime = (float*)RELOCATION_ID(523660, 410199).address();          // 2F6B948
-		it->second += *g_deltaTime;
-		it++;
-	}
+		auto actor = RE::Actor::LookupByHandle(record.actor);
+		if (!actor) {
+			continue;
+		}
+		switch (record.type) {
+		case EffectRecord::Type::kParry:
+			playParryEffects(actor.get());
+			break;
+		case EffectRecord::Type::kGuardBash:
+			playGuardBashEffects(actor.get());
+			break;
+		case EffectRecord::Type::kMeleeParryEvent:
+			sendModEvent(_meleeParryEventName, actor.get());
+			break;
+		default:
+			break;
+		}
+	} while (++drained < EffectQueue::CAPACITY && _effectQueue.pop(record));
 }
 
 void EldenParry::startTimingParry(RE::Actor* a_actor) {
+	const auto& settings = Settings::get();
+	double now = ParryClock::now(settings.bUseRealTimeParryWindow);
+	auto   recorder = TraceRecorder::GetSingleton();
+	bool stored = _actorStates.modify(
+		a_actor->GetHandle().native_handle(), [now, a_actor, recorder](ActorState& a_state) {
+			a_state.parryStart = now;
+			a_state.set(ActorState::kTimingParry);
+			if (recorder->enabled()) {
+				recorder->record(TraceRecorder::makeRecord(ParryCore::TraceRecord::Type::kBashStart, now, a_actor));
+			}
+		},
+		now - settings.fParryWindow_End);
+	if (!stored) {
+		warnTableFull(a_actor);
+	}
+}
 
-	uniqueLocker lock(mtx_parryTimer);
-	auto it = _parryTimer.find(a_actor);
-	if (it != _parryTimer.end()) {
-		it->second = 0;
-	} else {
-		_parryTimer.insert({a_actor, 0.0f});
+/// <summary>
+/// Report a parry window that could not be recorded, at most once per TABLE_FULL_WARNING_INTERVAL.
+/// </summary>
+void EldenParry::warnTableFull(RE::Actor* a_actor) {
+	auto dropped = _droppedParryWindows.fetch_add(1, std::memory_order_relaxed) + 1;
+	const double now = ParryClock::realNow();
+	double nextWarning = _nextTableFullWarning.load(std::memory_order_relaxed);
+	if (now < nextWarning || !_nextTableFullWarning.compare_exchange_strong(nextWarning, now + TABLE_FULL_WARNING_INTERVAL, std::memory_order_relaxed)) {
+		return;
 	}
-	
-	_bUpdate = true;
+	_droppedParryWindows.fetch_sub(dropped, std::memory_order_relaxed);
+	HOTLOG_WARN("Parry state table is full, ignoring parry from {} ({} parry windows dropped since the last warning)", a_actor->GetName(), dropped);
+}
+
+/// <summary>
+/// End the actor's bash: close their parry window and, if enabled, charge the cached parry cost
+/// unless the bash parried something. Takes a single lookup.
+/// </summary>
+/// <param name="a_actor"></param>
+void EldenParry::finishBash(RE::Actor* a_actor) {
+	const auto& settings = Settings::get();
+	bool        settleCost = settings.bSuccessfulParryNoCost;
+	float       due = 0.0f;
+	double      now = ParryClock::now(settings.bUseRealTimeParryWindow);
+	auto        recorder = TraceRecorder::GetSingleton();
+	_actorStates.modify(
+		a_actor->GetHandle().native_handle(), [settleCost, &due, now, a_actor, recorder](ActorState& a_state) {
+			due = ParryCore::finishBash(a_state, settleCost);
+			if (recorder->enabled()) {
+				auto record = TraceRecorder::makeRecord(ParryCore::TraceRecord::Type::kBashEnd, now, a_actor);
+				record.value = due;
+				recorder->record(record);
+			}
+		},
+		now - settings.fParryWindow_End);
+	if (due > 0.0f) {
+		inlineUtils::damageAv(a_actor, RE::ActorValue::kStamina, due);
+	}
+}
+
+void EldenParry::purge(RE::TESObjectREFR* a_ref) {
+	_actorStates.erase(a_ref->GetHandle().native_handle());
 }
 
-void EldenParry::finishTimingParry(RE::Actor* a_actor) {
-	uniqueLocker lock(mtx_parryTimer);
-	_parryTimer.erase(a_actor);
+void EldenParry::purgeAll() {
+	_suppressedContacts.clear();
+	_actorStates.clear();
 }
 
 /// <summary>
@@ -91,46 +220,85 @@ void EldenParry::finishTimingParry(RE::Actor* a_actor) {
 /// <returns>True if the object is in blocker's blocking angle.</returns>
 bool EldenParry::inBlockAngle(RE::Actor* a_blocker, RE::TESObjectREFR* a_obj)
 {
-	auto angle = a_blocker->GetHeadingAngle(a_obj->GetPosition(), false);
-	return (angle <= _parryAngle && angle >= -_parryAngle);
+	return ParryCore::inBlockAngle(CoreAdapter::poseOf(a_blocker), CoreAdapter::toVec3(a_obj->GetPosition()), _parryAngle);
 }
-/// <summary>
-/// Check if the actor is in parry state i.e. they are able to parry the incoming attack/projectile.
-/// </summary>
-/// <param name="a_actor"></param>
-/// <returns></returns>
-bool EldenParry::inParryState(RE::Actor* a_actor)
+bool EldenParry::isActiveParrier(RE::Actor* a_actor) const
+{
+	ActorState state;
+	return _actorStates.find(a_actor->GetHandle().native_handle(), state) && state.has(ActorState::kTimingParry);
+}
+
+double EldenParry::parryWindowRemaining(RE::Actor* a_actor) const
 {
-	sharedLocker lock(mtx_parryTimer);
-	auto it = _parryTimer.find(a_actor);
-	if (it != _parryTimer.end()) {
-		return it->second >= Settings::fParryWindow_Start;
+	const auto& settings = Settings::get();
+	ActorState state;
+	if (!_actorStates.find(a_actor->GetHandle().native_handle(), state) || !state.has(ActorState::kTimingParry)) {
+		return 0.0;
 	}
-	return false;
+	return CoreAdapter::parryWindow(settings).remaining(ParryClock::now(settings.bUseRealTimeParryWindow) - state.parryStart);
+}
+
+ParryCore::StaggerTier EldenParry::predictStaggerTier(RE::Actor* a_defender, RE::Actor* a_aggressor)
+{
+	return ParryCore::staggerTier(queryScore(a_aggressor) - queryScore(a_defender));
 }
 
-bool EldenParry::canParry(RE::Actor* a_parrier, RE::TESObjectREFR* a_obj)
+double EldenParry::queryScore(RE::Actor* a_actor)
 {
-	logger::info("{}",a_parrier->GetName());
-	return inParryState(a_parrier) && inBlockAngle(a_parrier, a_obj);
+	const auto& scores = Settings::get().scores;
+	if (std::this_thread::get_id() == _mainThread) {
+		return GetScore(a_actor, scores);
+	}
+	ActorState state;
+	if (!_actorStates.find(a_actor->GetHandle().native_handle(), state) || !state.has(ActorState::kScoreCached)) {
+		return 0.0;
+	}
+	return ParryCore::attackScore(state.staticScore, inlineUtils::isPowerAttacking(a_actor), CoreAdapter::scoreWeights(scores));
+}
+
+bool EldenParry::canParry(RE::Actor* a_parrier, RE::TESObjectREFR* a_obj, bool a_resolved)
+{
+	HOTLOG_TRACE("canParry: {}", a_parrier->GetName());
+	const auto& settings = Settings::get();
+	double      now = ParryClock::now(settings.bUseRealTimeParryWindow);
+	ActorState  state;
+	bool        found = _actorStates.find(a_parrier->GetHandle().native_handle(), state);
+	auto        pose = CoreAdapter::poseOf(a_parrier);
+	auto        target = CoreAdapter::toVec3(a_obj->GetPosition());
+	//a resolution from the pre-physics step already checked the block angle, but the bash may have ended since.
+	bool        result = a_resolved ? found && state.has(ActorState::kTimingParry) && CoreAdapter::parryWindow(settings).contains(now - state.parryStart) :
+	                                  ParryCore::canParry(found ? &state : nullptr, now, CoreAdapter::parryWindow(settings), pose, target, _parryAngle);
+
+	if (auto recorder = TraceRecorder::GetSingleton(); recorder->enabled()) {
+		auto type = a_obj->Is(RE::FormType::ActorCharacter) ? ParryCore::TraceRecord::Type::kMeleeHit : ParryCore::TraceRecord::Type::kProjectileContact;
+		auto record = TraceRecorder::makeRecord(type, now, a_parrier, a_obj);
+		record.pose = pose;
+		record.target = target;
+		record.flags = result ? ParryCore::TraceRecord::kParried : ParryCore::TraceRecord::kNone;
+		recorder->record(record);
+	}
+	return result;
 }
 
 
-bool EldenParry::processMeleeParry(RE::Actor* a_attacker, RE::Actor* a_parrier)
+bool EldenParry::processMeleeParry(RE::Actor* a_attacker, RE::Actor* a_parrier, bool a_resolved)
 {
-	if (canParry(a_parrier, a_attacker)) {
-		playParryEffects(a_parrier);
+	const auto& settings = Settings::get();
+	if (canParry(a_parrier, a_attacker, a_resolved)) {
+		suppressSwingContacts(a_attacker, a_parrier);
+		queueEffect(a_parrier, EffectRecord::Type::kParry);
 		Utils::triggerStagger(a_parrier, a_attacker);
 		if (Settings::facts::isValhallaCombatAPIObtained) {
 			_ValhallaCombat_API->processStunDamage(VAL_API::STUNSOURCE::parry, nullptr, a_parrier, a_attacker, 0);
 		}
 		if (a_parrier->IsPlayerRef()) {
-			RE::PlayerCharacter::GetSingleton()->AddSkillExperience(RE::ActorValue::kBlock, Settings::fMeleeParryExp);
+			RE::PlayerCharacter::GetSingleton()->AddSkillExperience(RE::ActorValue::kBlock, settings.fMeleeParryExp);
 		}
-		if (Settings::bSuccessfulParryNoCost) {
+		if (settings.bSuccessfulParryNoCost) {
 			negateParryCost(a_parrier);
 		}
 		send_melee_parry_event(a_attacker);
+		notifyParry(a_parrier, a_attacker, nullptr);
 		return true;
 	}
 
@@ -148,6 +316,7 @@ bool EldenParry::processMeleeParry(RE::Actor* a_attacker, RE::Actor* a_parrier)
 /// <returns>True if the projectile parry is successful.</returns>
 bool EldenParry::processProjectileParry(RE::Actor* a_parrier, RE::Projectile* a_projectile, RE::hkpCollidable* a_projectile_collidable)
 {
+	const auto& settings = Settings::get();
 	if (canParry(a_parrier, a_projectile)) {
 		RE::TESObjectREFR* shooter = nullptr;
 		if (a_projectile->GetProjectileRuntimeData().shooter && a_projectile->GetProjectileRuntimeData().shooter.get()) {
@@ -162,14 +331,15 @@ bool EldenParry::processProjectileParry(RE::Actor* a_parrier, RE::Projectile* a_
 			Utils::ReflectProjectile(a_projectile);
 		}
 		
-		playParryEffects(a_parrier);
+		queueEffect(a_parrier, EffectRecord::Type::kParry);
 		if (a_parrier->IsPlayerRef()) {
-			RE::PlayerCharacter::GetSingleton()->AddSkillExperience(RE::ActorValue::kBlock, Settings::fProjectileParryExp);
+			RE::PlayerCharacter::GetSingleton()->AddSkillExperience(RE::ActorValue::kBlock, settings.fProjectileParryExp);
 		}
-		if (Settings::bSuccessfulParryNoCost) {
+		if (settings.bSuccessfulParryNoCost) {
 			negateParryCost(a_parrier);
 		}
 		send_ranged_parry_event();
+		notifyParry(a_parrier, shooter ? shooter->As<RE::Actor>() : nullptr, a_projectile);
 		return true;
 	}
 	return false;
@@ -182,109 +352,248 @@ void EldenParry::processGuardBash(RE::Actor* a_basher, RE::Actor* a_blocker)
 		return;
 	}
 	Utils::triggerStagger(a_basher, a_blocker);
-	playGuardBashEffects(a_basher);
-	RE::PlayerCharacter::GetSingleton()->AddSkillExperience(RE::ActorValue::kBlock, Settings::fGuardBashExp);
+	queueEffect(a_basher, EffectRecord::Type::kGuardBash);
+	RE::PlayerCharacter::GetSingleton()->AddSkillExperience(RE::ActorValue::kBlock, Settings::get().fGuardBashExp);
 }
 
 void EldenParry::playParryEffects(RE::Actor* a_parrier) {
-	if (Settings::bEnableParrySoundEffect) {
+	const auto& settings = Settings::get();
+	if (settings.bEnableParrySoundEffect) {
 		if (Utils::isEquippedShield(a_parrier)) {
 			Utils::playSound(a_parrier, _parrySound_shd);
 		} else {
 			Utils::playSound(a_parrier, _parrySound_wpn);
 		}
 	}
-	if (Settings::bEnableParrySparkEffect) {
+	if (settings.bEnableParrySparkEffect) {
 		blockSpark::playBlockSpark(a_parrier);
 	}
 	if (a_parrier->IsPlayerRef()) {
-		if (Settings::bEnableSlowTimeEffect) {
+		if (settings.bEnableSlowTimeEffect) {
 			Utils::slowTime(0.2f, 0.3f);
 		}
-		if (Settings::bEnableScreenShakeEffect) {
+		if (settings.bEnableScreenShakeEffect) {
 			inlineUtils::shakeCamera(1.5, a_parrier->GetPosition(), 0.4f);
 		}
 	}
 	
 }
 
-void EldenParry::applyParryCost(RE::Actor* a_actor) {
-	//logger::logger::info("apply parry cost for {}", a_actor->GetName());
-	std::lock_guard<std::shared_mutex> lock(mtx_parryCostQueue);
-	std::lock_guard<std::shared_mutex> lock2(mtx_parrySuccessActors);
-	if (_parryCostQueue.contains(a_actor)) {
-		if (!_parrySuccessActors.contains(a_actor)) {
-			inlineUtils::damageAv(a_actor, RE::ActorValue::kStamina, _parryCostQueue[a_actor]);
-		}
-		_parryCostQueue.erase(a_actor);
-	}
-	_parrySuccessActors.erase(a_actor);
-}
-
 void EldenParry::cacheParryCost(RE::Actor* a_actor, float a_cost) {
+	const auto& settings = Settings::get();
 	//logger::logger::info("cache parry cost for {}: {}", a_actor->GetName(), a_cost);
-	std::lock_guard<std::shared_mutex> lock(mtx_parryCostQueue);
-	_parryCostQueue[a_actor] = a_cost;
+	double now = ParryClock::now(settings.bUseRealTimeParryWindow);
+	auto   recorder = TraceRecorder::GetSingleton();
+	_actorStates.modify(
+		a_actor->GetHandle().native_handle(), [a_cost, now, a_actor, recorder](ActorState& a_state) {
+			a_state.parryCost = a_cost;
+			a_state.set(ActorState::kParryCostCached);
+			if (recorder->enabled()) {
+				auto record = TraceRecorder::makeRecord(ParryCore::TraceRecord::Type::kStaminaCost, now, a_actor);
+				record.value = a_cost;
+				recorder->record(record);
+			}
+		},
+		now - settings.fParryWindow_End);
 }
 
 void EldenParry::negateParryCost(RE::Actor* a_actor) {
 	//logger::logger::info("negate parry cost for {}", a_actor->GetName());
-	std::lock_guard<std::shared_mutex> lock(mtx_parrySuccessActors);
-	_parrySuccessActors.insert(a_actor);
+	_actorStates.modify(
+		a_actor->GetHandle().native_handle(), [](ActorState& a_state) {
+			a_state.set(ActorState::kParrySucceeded);
+		},
+		expiredBefore());
 }
 
 void EldenParry::playGuardBashEffects(RE::Actor* a_actor) {
-	if (Settings::bEnableParrySoundEffect) {
+	const auto& settings = Settings::get();
+	if (settings.bEnableParrySoundEffect) {
 			Utils::playSound(a_actor, _parrySound_shd);
 	}
-	if (Settings::bEnableParrySparkEffect) {
+	if (settings.bEnableParrySparkEffect) {
 		blockSpark::playBlockSpark(a_actor);
 	}
 	if (a_actor->IsPlayerRef()) {
-		if (Settings::bEnableSlowTimeEffect) {
+		if (settings.bEnableSlowTimeEffect) {
 			Utils::slowTime(0.2f, 0.3f);
 		}
-		if (Settings::bEnableScreenShakeEffect) {
+		if (settings.bEnableScreenShakeEffect) {
 			inlineUtils::shakeCamera(1.5, a_actor->GetPosition(), 0.4f);
 		}
 	}
 }
 
 void EldenParry::send_melee_parry_event(RE::Actor* a_attacker) {
-	SKSE::ModCallbackEvent modEvent{
-				RE::BSFixedString("EP_MeleeParryEvent"),
-				RE::BSFixedString(),
-				0.0f,
-				a_attacker
-	};
-
-	SKSE::GetModCallbackEventSource()->SendEvent(&modEvent);
-	logger::info("Sent melee parry event");
+	if (Settings::get().bSendModEvents) {
+		queueEffect(a_attacker, EffectRecord::Type::kMeleeParryEvent);
+	}
 }
 
 void EldenParry::send_ranged_parry_event() {
+	if (Settings::get().bSendModEvents && !_effectQueue.push({ 0, EffectRecord::Type::kRangedParryEvent })) {
+		HOTLOG_WARN("Effect queue is full, dropping ranged parry event");
+	}
+}
+
+void EldenParry::sendModEvent(const RE::BSFixedString& a_eventName, RE::Actor* a_sender) {
 	SKSE::ModCallbackEvent modEvent{
-				RE::BSFixedString("EP_RangedParryEvent"),
-				RE::BSFixedString(),
+				a_eventName,
+				_emptyString,
 				0.0f,
-				nullptr
+				a_sender
 	};
 
 	SKSE::GetModCallbackEventSource()->SendEvent(&modEvent);
-	logger::info("Sent ranged parry event");
+	HOTLOG_DEBUG("Sent {}", a_eventName.c_str());
+}
+
+void EldenParry::notifyParry(RE::Actor* a_parrier, RE::Actor* a_attacker, RE::Projectile* a_projectile) {
+	auto api = Messaging::EldenParryInterface::GetSingleton();
+	if (!api->hasParryCallbacks()) {
+		return;
+	}
+	EP_API::ParryEventData data{
+		a_projectile ? EP_API::ParryEventData::Type::Projectile : EP_API::ParryEventData::Type::Melee,
+		a_parrier,
+		a_attacker,
+		a_projectile,
+		0.0,
+		0.0
+	};
+	if (a_attacker) {
+		// projectile parries are reported from havok threads, where only cached scores may be read.
+		data.attackerScore = queryScore(a_attacker);
+		data.parrierScore = queryScore(a_parrier);
+	}
+	api->dispatchParry(data);
 }
 
 PRECISION_API::PreHitCallbackReturn EldenParry::precisionPrehitCallbackFunc(const PRECISION_API::PrecisionHitData& a_precisionHitData) {
+	LatencyScope latency(LatencyProbe::kPrecisionPrehit);
 	PRECISION_API::PreHitCallbackReturn returnData;
 	if (!a_precisionHitData.target || !a_precisionHitData.target->Is(RE::FormType::ActorCharacter)) {
 		return returnData;
 	}
-	if (EldenParry::GetSingleton()->processMeleeParry(a_precisionHitData.attacker, a_precisionHitData.target->As<RE::Actor>())) {
+	auto eldenParry = EldenParry::GetSingleton();
+	auto parrier = a_precisionHitData.target->As<RE::Actor>();
+	bool resolved = eldenParry->_pendingParries.size() != 0 &&
+	                eldenParry->_pendingParries.contains(a_precisionHitData.attacker->GetHandle().native_handle(), parrier->GetHandle().native_handle(),
+						ParryClock::now(Settings::get().bUseRealTimeParryWindow) - MAX_RESOLUTION_AGE);
+	if (eldenParry->processMeleeParry(a_precisionHitData.attacker, parrier, resolved)) {
 		returnData.bIgnoreHit = true;
 	}
 	return returnData;
 }
 
+void EldenParry::precisionPrePhysicsStepCallbackFunc(RE::bhkWorld*) {
+	LatencyScope latency(LatencyProbe::kPrePhysicsStep);
+	EldenParry::GetSingleton()->resolvePendingParries();
+}
+
+PRECISION_API::CollisionFilterComparisonResult EldenParry::precisionCollisionFilterComparisonCallbackFunc(RE::bhkCollisionFilter*, uint32_t a_filterInfoA, uint32_t a_filterInfoB) {
+	auto& suppressedContacts = EldenParry::GetSingleton()->_suppressedContacts;
+	const auto groupA = static_cast<SuppressedContacts::Group>(a_filterInfoA >> 16);
+	const auto groupB = static_cast<SuppressedContacts::Group>(a_filterInfoB >> 16);
+	if (groupA == groupB || !suppressedContacts.contains(groupA, groupB)) {
+		return PRECISION_API::CollisionFilterComparisonResult::Continue;
+	}
+	//keep the character controllers colliding, so the actors don't walk through each other.
+	const auto layerA = static_cast<RE::COL_LAYER>(a_filterInfoA & 0x7F);
+	const auto layerB = static_cast<RE::COL_LAYER>(a_filterInfoB & 0x7F);
+	if (layerA == RE::COL_LAYER::kCharController || layerB == RE::COL_LAYER::kCharController) {
+		return PRECISION_API::CollisionFilterComparisonResult::Continue;
+	}
+	return PRECISION_API::CollisionFilterComparisonResult::Ignore;
+}
+
+void EldenParry::suppressSwingContacts(RE::Actor* a_attacker, RE::Actor* a_parrier) {
+	std::uint32_t attackerFilterInfo = 0;
+	std::uint32_t parrierFilterInfo = 0;
+	a_attacker->GetCollisionFilterInfo(attackerFilterInfo);
+	a_parrier->GetCollisionFilterInfo(parrierFilterInfo);
+	_suppressedContacts.add(static_cast<SuppressedContacts::Group>(attackerFilterInfo >> 16), static_cast<SuppressedContacts::Group>(parrierFilterInfo >> 16),
+		a_attacker->GetHandle().native_handle(), a_parrier->GetHandle().native_handle());
+}
+
+void EldenParry::sweepSuppressedContacts() {
+	_suppressedContacts.sweep([](SuppressedContacts::Key a_attacker, SuppressedContacts::Key a_parrier) {
+		auto attacker = RE::Actor::LookupByHandle(a_attacker);
+		auto parrier = RE::Actor::LookupByHandle(a_parrier);
+		if (!attacker || !parrier) {
+			return false;
+		}
+		//the swing is over once the attacker leaves it, or as soon as the parrier winds up a riposte, so the riposte's contacts go through.
+		const auto attackState = attacker->AsActorState()->GetAttackState();
+		const auto parrierState = parrier->AsActorState()->GetAttackState();
+		const bool swinging = attackState == RE::ATTACK_STATE_ENUM::kSwing || attackState == RE::ATTACK_STATE_ENUM::kHit;
+		const bool parrierAttacking = parrierState != RE::ATTACK_STATE_ENUM::kNone && parrierState != RE::ATTACK_STATE_ENUM::kBash;
+		return swinging && !parrierAttacking;
+	});
+}
+
+void EldenParry::resolvePendingParries() {
+	if (!hasActiveParriers()) {
+		if (_pendingParries.size() != 0) {
+			_pendingParries.clear();
+		}
+		return;
+	}
+	const auto& settings = Settings::get();
+	const double now = ParryClock::now(settings.bUseRealTimeParryWindow);
+	const auto window = CoreAdapter::parryWindow(settings);
+
+	struct Parrier
+	{
+		PendingParries::Key      key;
+		ActorState               state;
+		RE::NiPointer<RE::Actor> actor;
+		ParryCore::Pose          pose;
+	};
+	std::array<Parrier, PendingParries::CAPACITY> parriers;
+	std::size_t numParriers = 0;
+	_actorStates.forEachTiming([&](ActorStateTable::Key a_key, const ActorState& a_state) {
+		if (numParriers == parriers.size() || !window.contains(now - a_state.parryStart)) {
+			return;
+		}
+		if (auto actor = RE::Actor::LookupByHandle(a_key)) {
+			parriers[numParriers++] = { a_key, a_state, actor, CoreAdapter::poseOf(actor.get()) };
+		}
+	});
+
+	std::array<PendingParries::Pair, PendingParries::CAPACITY> pairs;
+	std::size_t numPairs = 0;
+	auto sweep = [&](RE::Actor* a_attacker) {
+		auto attackState = a_attacker->AsActorState()->GetAttackState();
+		if (attackState != RE::ATTACK_STATE_ENUM::kSwing && attackState != RE::ATTACK_STATE_ENUM::kHit) {
+			return;
+		}
+		auto position = CoreAdapter::toVec3(a_attacker->GetPosition());
+		for (std::size_t i = 0; i < numParriers && numPairs < pairs.size(); ++i) {
+			const auto& parrier = parriers[i];
+			if (parrier.actor.get() == a_attacker || (parrier.pose.position - position).sqrLength() > SWEEP_RANGE * SWEEP_RANGE) {
+				continue;
+			}
+			if (ParryCore::canParry(&parrier.state, now, window, parrier.pose, position, _parryAngle)) {
+				pairs[numPairs++] = { a_attacker->GetHandle().native_handle(), parrier.key };
+			}
+		}
+	};
+	if (numParriers != 0) {
+		if (auto player = RE::PlayerCharacter::GetSingleton()) {
+			sweep(player);
+		}
+		if (auto processLists = RE::ProcessLists::GetSingleton()) {
+			for (auto& handle : processLists->highActorHandles) {
+				if (auto actor = handle.get().get(); actor && actor->Is3DLoaded()) {
+					sweep(actor);
+				}
+			}
+		}
+	}
+	_pendingParries.publish({ pairs.data(), numPairs }, now);
+}
+
 const RE::TESObjectWEAP *const EldenParry::GetAttackWeapon(RE::AIProcess *const aiProcess)
 {
 	if (aiProcess && aiProcess->high && aiProcess->high->attackData &&
@@ -305,151 +614,86 @@ const RE::TESObjectWEAP *const EldenParry::GetAttackWeapon(RE::AIProcess *const
 
 double EldenParry::GetScore(RE::Actor *actor, const Milf::Scores &scoreSettings)
 {
-	double score = 0.0;
+	return ParryCore::attackScore(GetCachedStaticScore(actor, scoreSettings), inlineUtils::isPowerAttacking(actor), CoreAdapter::scoreWeights(scoreSettings));
+}
 
-	RE::TESObjectWEAP* weapon = nullptr;
+/// <summary>
+/// Get the static part of the actor's score from the cache, computing and caching it on a miss.
+/// </summary>
+/// <param name="actor"></param>
+/// <param name="scoreSettings"></param>
+/// <returns>The score without the per-attack terms.</returns>
+double EldenParry::GetCachedStaticScore(RE::Actor *actor, const Milf::Scores &scoreSettings)
+{
+	const auto key = actor->GetHandle().native_handle();
+	ActorState state;
+	if (_actorStates.find(key, state) && state.has(ActorState::kScoreCached)) {
+		return state.staticScore;
+	}
+
+	const float staticScore = static_cast<float>(GetStaticScore(actor, scoreSettings));
+	_actorStates.modify(
+		key, [staticScore](ActorState &a_state) {
+			a_state.staticScore = staticScore;
+			a_state.set(ActorState::kScoreCached);
+		},
+		expiredBefore());
+	return staticScore;
+}
 
-	bool WeaponShield = false;
+void EldenParry::invalidateAllScores()
+{
+	_actorStates.clearFlag(ActorState::kScoreCached);
+}
 
-	auto defenderLeftEquipped = actor->GetEquippedObject(true);
-	auto defenderRightEquipped = actor->GetEquippedObject(false);
-	
-	if (defenderLeftEquipped && (defenderLeftEquipped->IsWeapon() || defenderLeftEquipped->IsArmor())) {
+void EldenParry::invalidateScore(RE::TESObjectREFR *a_ref)
+{
+	_actorStates.modify(
+		a_ref->GetHandle().native_handle(), [](ActorState &a_state) {
+			a_state.clear(ActorState::kScoreCached);
+		},
+		expiredBefore());
+}
 
-		if (defenderLeftEquipped->As<RE::TESObjectWEAP>()) {
-			weapon = (defenderLeftEquipped->As<RE::TESObjectWEAP>());
-		
-			switch (weapon->GetWeaponType()) {
-			case RE::WEAPON_TYPE::kOneHandSword:
-				score += scoreSettings.oneHandSwordScore;
-				break;
-			case RE::WEAPON_TYPE::kOneHandAxe:
-			    score += scoreSettings.oneHandAxeScore;
-				break;
-			case RE::WEAPON_TYPE::kOneHandMace:
-			    score += scoreSettings.oneHandMaceScore;
-				break;
-			case RE::WEAPON_TYPE::kOneHandDagger:
-			    score += scoreSettings.oneHandDaggerScore;
-				break;
-			}
-		} else if (defenderLeftEquipped->IsArmor()) {
-			WeaponShield = true;
-			score += 70.0;
-		}
+/// <summary>
+/// Compute the part of the actor's score that only changes with equipment, skills or race.
+/// </summary>
+/// <param name="actor"></param>
+/// <param name="scoreSettings"></param>
+/// <returns></returns>
+double EldenParry::GetStaticScore(RE::Actor *actor, const Milf::Scores &scoreSettings)
+{
+	ParryCore::ScoreInputs inputs;
 
-	} else if (defenderRightEquipped && (defenderRightEquipped->IsWeapon())) {
-		weapon = (defenderRightEquipped->As<RE::TESObjectWEAP>());
-		switch (weapon->GetWeaponType())
-		{
-		case RE::WEAPON_TYPE::kOneHandSword:
-			score += scoreSettings.oneHandSwordScore;
-			break;
-		case RE::WEAPON_TYPE::kOneHandAxe:
-			score += scoreSettings.oneHandAxeScore;
-			break;
-		case RE::WEAPON_TYPE::kOneHandMace:
-			score += scoreSettings.oneHandMaceScore;
-			break;
-		case RE::WEAPON_TYPE::kOneHandDagger:
-			score += scoreSettings.oneHandDaggerScore;
-			break;
-		case RE::WEAPON_TYPE::kTwoHandAxe:
-			score += scoreSettings.twoHandAxeScore;
-			break;
-		case RE::WEAPON_TYPE::kTwoHandSword:
-			score += scoreSettings.twoHandSwordScore;
-			break;
-		case RE::WEAPON_TYPE::kHandToHandMelee:
-			score += -50.0;
-			break;
-		}
-	}
+	auto tables = ScoreTables::GetSingleton();
 
-	if (WeaponShield == false) {
+	auto defenderLeftEquipped = actor->GetEquippedObject(true);
+	auto defenderRightEquipped = actor->GetEquippedObject(false);
 
-		const auto actorValue = weapon->weaponData.skill.get();
-		switch (actorValue)
-		{
-		case RE::ActorValue::kOneHanded:
-			score += (scoreSettings.weaponSkillWeight *
-					  actor->AsActorValueOwner()->GetActorValue(RE::ActorValue::kOneHanded));
-			break;
-		case RE::ActorValue::kTwoHanded:
-			score += (scoreSettings.weaponSkillWeight *
-					  actor->AsActorValueOwner()->GetActorValue(RE::ActorValue::kTwoHanded));
-			break;
-		default:
-			// Do nothing
-			break;
-		}
+	RE::ActorValue skill = RE::ActorValue::kNone;
+	if (defenderLeftEquipped && defenderLeftEquipped->IsArmor()) {
+		inputs.shield = true;
+		skill = RE::ActorValue::kBlock;
 	} else {
-		score += (scoreSettings.weaponSkillWeight *
-				  actor->AsActorValueOwner()->GetActorValue(RE::ActorValue::kBlock));
-	}
-
-	
-	const auto race = actor->GetRace();
-	const auto raceFormID = race->formID;
-
-	if (raceFormID == 0x13743 || raceFormID == 0x88840)
-	{
-		score += scoreSettings.altmerScore;
-	}
-	else if (raceFormID == 0x13740 || raceFormID == 0x8883A)
-	{
-		score += scoreSettings.argonianScore;
-	}
-	else if (raceFormID == 0x13749 || raceFormID == 0x88884)
-	{
-		score += scoreSettings.bosmerScore;
-	}
-	else if (raceFormID == 0x13741 || raceFormID == 0x8883C)
-	{
-		score += scoreSettings.bretonScore;
-	}
-	else if (raceFormID == 0x13742 || raceFormID == 0x8883D)
-	{
-		score += scoreSettings.dunmerScore;
-	}
-	else if (raceFormID == 0x13744 || raceFormID == 0x88844)
-	{
-		score += scoreSettings.imperialScore;
-	}
-	else if (raceFormID == 0x13745 || raceFormID == 0x88845)
-	{
-		score += scoreSettings.khajiitScore;
-	}
-	else if (raceFormID == 0x13746 || raceFormID == 0x88794)
-	{
-		score += scoreSettings.nordScore;
-	}
-	else if (raceFormID == 0x13747 || raceFormID == 0xA82B9)
-	{
-		score += scoreSettings.orcScore;
-	}
-	else if (raceFormID == 0x13748 || raceFormID == 0x88846)
-	{
-		score += scoreSettings.redguardScore;
+		const RE::TESForm* equipped = defenderLeftEquipped && defenderLeftEquipped->IsWeapon() ? defenderLeftEquipped : defenderRightEquipped;
+		if (equipped && equipped->IsWeapon()) {
+			const auto weaponClass = tables->getWeaponClass(equipped->As<RE::TESObjectWEAP>());
+			inputs.weaponScore = weaponClass.score;
+			skill = weaponClass.skill;
+		}
 	}
 
-	const auto actorBase = actor->GetActorBase();
-	if (actorBase && actorBase->IsFemale())
-	{
-		score += scoreSettings.femaleScore;
+	if (skill != RE::ActorValue::kNone) {
+		inputs.skillLevel = actor->AsActorValueOwner()->GetActorValue(skill);
 	}
 
-	if (inlineUtils::isPowerAttacking(actor))
-	{
-		score += scoreSettings.powerAttackScore;
-	}
+	inputs.raceScore = tables->getRaceScore(actor->GetRace());
 
-	if (actor->IsPlayerRef())
-	{
-		score += scoreSettings.playerScore;
-	}
+	const auto actorBase = actor->GetActorBase();
+	inputs.female = actorBase && actorBase->IsFemale();
+	inputs.player = actor->IsPlayerRef();
 
-	return score;
+	return ParryCore::staticScore(inputs, CoreAdapter::scoreWeights(scoreSettings));
 }
 
 
@@ -460,8 +704,9 @@ double EldenParry::AttackerBeatsParry(RE::Actor *attacker, RE::Actor *target)
 	// 	// The score-based system has been disabled in INI, so attackers can never overpower parries
 	// 	return false;
 	// }
-	const double attackerScore = GetScore(attacker, Milf::GetSingleton()->scores);
-	const double targetScore = GetScore(target, Milf::GetSingleton()->scores);
+	const auto& scores = Settings::get().scores;
+	const double attackerScore = GetScore(attacker, scores);
+	const double targetScore = GetScore(target, scores);
 
 	return (attackerScore - targetScore); // >= Milf::GetSingleton()->scores.scoreDiffThreshold);
 }
@@ -475,17 +720,27 @@ Milf *Milf::GetSingleton()
 
 void Milf::Load()
 {
-	constexpr auto path = "Data\\SKSE\\Plugins\\EldenRiposteSystem.ini";
+	std::string original;
+	if (std::ifstream file{ path, std::ios::binary }) {
+		original.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
 
 	CSimpleIniA ini;
 	ini.SetUnicode();
 
-	ini.LoadFile(path);
+	ini.LoadData(original);
 
 	core.Load(ini);
 	scores.Load(ini);
+	races.Load(ini);
 
-	ini.SaveFile(path);
+	// keep the file untouched unless loading added entries to it.
+	const bool  signature = original.empty() || original.starts_with("\xEF\xBB\xBF");
+	std::string updated;
+	ini.Save(updated, signature);
+	if (updated != original) {
+		ini.SaveFile(path, signature);
+	}
 }
 
 void Milf::Core::Load(CSimpleIniA &a_ini)
@@ -563,4 +818,25 @@ void Milf::Scores::Load(CSimpleIniA &a_ini)
 					  ";Bonus score for power attacks.");
 
 	detail::get_value(a_ini, playerScore, section, "PlayerScore", ";Bonus score for the Player.");
+}
+
+void Milf::Races::Load(CSimpleIniA &a_ini)
+{
+	auto readSection = [&a_ini](const char *a_section, const char *a_comment, std::vector<std::pair<std::string, double>> &a_out) {
+		a_out.clear();
+		CSimpleIniA::TNamesDepend keys;
+		if (!a_ini.GetAllKeys(a_section, keys)) {
+			a_ini.SetValue(a_section, nullptr, nullptr, a_comment);
+			return;
+		}
+		keys.sort(CSimpleIniA::Entry::LoadOrder());
+		for (const auto &key : keys) {
+			a_out.emplace_back(key.pItem, a_ini.GetDoubleValue(a_section, key.pItem));
+		}
+	};
+
+	readSection("RaceScores", ";Bonus score for races by EditorID, e.g. MyCustomRace = 10.0. Overrides the vanilla race scores.",
+				editorIDScores);
+	readSection("RaceKeywordScores", ";Bonus score for races carrying a keyword, by keyword EditorID. The first matching keyword is used.",
+				keywordScores);
 }
\ No newline at end of file
@@ -2,20 +2,33 @@
 #include <memory>
 #include "lib/PrecisionAPI.h"
 #include "lib/ValhallaCombatAPI.h"
-#include <mutex>
-#include <shared_mutex>
-
-#include <unordered_set>
+#include "ParryCore/ActorStateTable.h"
+#include "ParryCore/ParryCore.h"
+#include "ParryCore/PendingParries.h"
+#include "ParryCore/SuppressedContacts.h"
+#include "EffectQueue.h"
 using std::string;
 
 class Milf
 {
 public:
+	static constexpr auto path = "Data\\SKSE\\Plugins\\EldenRiposteSystem.ini";
 
 	[[nodiscard]] static Milf *GetSingleton();
 
+	/*Read the settings, adding missing entries to the ini. The ini is only rewritten if that changed it.*/
 	void Load();
 
+	/*Visit every setting, for the settings snapshot.*/
+	template <class Archive>
+	void serialize(Archive &a_ar)
+	{
+		a_ar(core.useScoreSystem);
+		a_ar(scores);
+		a_ar(races.editorIDScores);
+		a_ar(races.keywordScores);
+	}
+
 	struct Core
 	{
 		void Load(CSimpleIniA &a_ini);
@@ -64,6 +77,15 @@ public:
 		double playerScore{0.0};
 	} scores;
 
+	/*Scores for races that are not vanilla playable races, mapped from the INI by EditorID or by keyword.*/
+	struct Races
+	{
+		void Load(CSimpleIniA &a_ini);
+
+		std::vector<std::pair<std::string, double>> editorIDScores;
+		std::vector<std::pair<std::string, double>> keywordScores;
+	} races;
+
 private:
 	Milf() = default;
 	Milf(const Milf &) = delete;
@@ -120,11 +142,18 @@ private:
 
 class EldenParry
 {   
+	friend class ParryBenchmark;
+
 public:
     double GetScore(RE::Actor *actor, const Milf::Scores &scoreSettings);
 	
 	double AttackerBeatsParry(RE::Actor *attacker, RE::Actor *target);
 
+	/*Forget the cached score of this reference, e.g. after it changed equipment, skill or race.*/
+	void invalidateScore(RE::TESObjectREFR *a_ref);
+	/*Forget all cached scores, e.g. after the score settings changed.*/
+	void invalidateAllScores();
+
 	const RE::TESObjectWEAP *const GetAttackWeapon(RE::AIProcess *const aiProcess);
 
 	static EldenParry *GetSingleton()
@@ -140,8 +169,9 @@ public:
 	/// </summary>
 	/// <param name="a_attacker"></param>
 	/// <param name="a_parrier"></param>
+	/// <param name="a_resolved">The parry was already resolved in the pre-physics step; only the parry window is checked again.</param>
 	/// <returns>True if the parry is successful.</returns>
-	bool processMeleeParry(RE::Actor *a_attacker, RE::Actor *a_parrier);
+	bool processMeleeParry(RE::Actor *a_attacker, RE::Actor *a_parrier, bool a_resolved = false);
 
 	bool processProjectileParry(RE::Actor *a_blocker, RE::Projectile *a_projectile, RE::hkpCollidable *a_projectile_collidable);
 
@@ -150,42 +180,89 @@ public:
 	PRECISION_API::IVPrecision1 *_precision_API;
 	VAL_API::IVVAL1 *_ValhallaCombat_API;
 
-	void applyParryCost(RE::Actor *a_actor);
+	/*Half angle, in degrees, within which a blocker can parry. Same as the game's hit cone.*/
+	float parryAngle() const { return _parryAngle; }
+
 	void cacheParryCost(RE::Actor *a_actor, float a_cost);
 
 	void negateParryCost(RE::Actor *a_actor);
 
-	void playGuardBashEffects(RE::Actor *a_actor);
+	/*True if any actor is currently in a bash, i.e. could parry. Windows that expired are cleared once per frame by update().
+	Lock-free; lets collision hooks bail out early.*/
+	bool hasActiveParriers() const { return _actorStates.timingCount() != 0; }
+	/*True if the actor is currently in a bash. Lock-free.*/
+	bool isActiveParrier(RE::Actor *a_actor) const;
+	/*Seconds left in the actor's parry window; 0 if it is not in one. Lock-free.*/
+	double parryWindowRemaining(RE::Actor *a_actor) const;
+	/*Who would stagger if the defender parried the aggressor now, from the scores given by queryScore().*/
+	ParryCore::StaggerTier predictStaggerTier(RE::Actor *a_defender, RE::Actor *a_aggressor);
+	/*Riposte score for queries from other plugins. On the main thread, same as GetScore. On any other thread, only the
+	cached score is read, without locking or querying the engine for the static part; 0 if none is cached.*/
+	double queryScore(RE::Actor *a_actor);
 
 	void startTimingParry(RE::Actor *a_actor);
-	void finishTimingParry(RE::Actor *a_actor);
+	void finishBash(RE::Actor *a_actor);
+
+	/*Drop all state held for this reference, e.g. when it dies or its cell is detached.*/
+	void purge(RE::TESObjectREFR *a_ref);
+	/*Drop all state, e.g. before a save is loaded.*/
+	void purgeAll();
 
+	/*Queue the Papyrus mod events, if enabled. They are sent on the main thread, at most one per sender and frame.*/
 	void send_melee_parry_event(RE::Actor *a_attacker);
 	void send_ranged_parry_event();
 
 	void update();
 
 private:
+	/*Queue an effect to be played on the main thread. Any thread.*/
+	void queueEffect(RE::Actor *a_actor, EffectRecord::Type a_type);
+	/*Main thread only.*/
+	void playQueuedEffects();
 	void playParryEffects(RE::Actor *a_parrier);
-
-	bool inParryState(RE::Actor *a_parrier);
-	bool canParry(RE::Actor *a_parrier, RE::TESObjectREFR *a_obj);
+	void playGuardBashEffects(RE::Actor *a_actor);
+	void warnTableFull(RE::Actor *a_actor);
+	/*Main thread only.*/
+	void sendModEvent(const RE::BSFixedString &a_eventName, RE::Actor *a_sender);
+	/*Run the parry callbacks registered through the API. Scores are only computed if there is a callback.*/
+	void notifyParry(RE::Actor *a_parrier, RE::Actor *a_attacker, RE::Projectile *a_projectile);
+
+	/*@param a_resolved: the pre-physics step found the parry; only check that the parrier's window is still open.*/
+	bool canParry(RE::Actor *a_parrier, RE::TESObjectREFR *a_obj, bool a_resolved = false);
 	bool inBlockAngle(RE::Actor *a_blocker, RE::TESObjectREFR *a_obj);
+	double GetCachedStaticScore(RE::Actor *actor, const Milf::Scores &scoreSettings);
+	double GetStaticScore(RE::Actor *actor, const Milf::Scores &scoreSettings);
 	static PRECISION_API::PreHitCallbackReturn precisionPrehitCallbackFunc(const PRECISION_API::PrecisionHitData &a_precisionHitData);
-
-	std::unordered_map<RE::Actor *, float> _parryCostQueue;
-	std::unordered_set<RE::Actor *> _parrySuccessActors;
-	std::unordered_map<RE::Actor *, float> _parryTimer;
+	static void precisionPrePhysicsStepCallbackFunc(RE::bhkWorld *a_world);
+	static PRECISION_API::CollisionFilterComparisonResult precisionCollisionFilterComparisonCallbackFunc(RE::bhkCollisionFilter *a_collisionFilter, uint32_t a_filterInfoA, uint32_t a_filterInfoB);
+	/*Drop the contacts of the rest of a parried swing, so they don't reach the hit callbacks again.*/
+	void suppressSwingContacts(RE::Actor *a_attacker, RE::Actor *a_parrier);
+	/*End the suppression of swings that are over. Main thread only.*/
+	void sweepSuppressedContacts();
+	/*Resolve the parries of the hits the coming physics step may produce: every actor swinging within reach of an actor
+	whose parry window is open. Their hits then only need a lookup.*/
+	void resolvePendingParries();
+
+	static constexpr float  SWEEP_RANGE = 400.0f;             // distance beyond which a swing can't reach the parrier this step.
+	static constexpr double MAX_RESOLUTION_AGE = 1.0 / 30.0;  // resolutions older than this, in seconds, are recomputed.
+
+	static constexpr double TABLE_FULL_WARNING_INTERVAL = 10.0;  // seconds between two "table is full" warnings.
+
+	ActorStateTable _actorStates;
+	std::atomic<std::uint32_t> _droppedParryWindows{ 0 };
+	std::atomic<double> _nextTableFullWarning{ 0.0 };
+	PendingParries _pendingParries;
+	SuppressedContacts _suppressedContacts;
+	EffectQueue _effectQueue;
 
 	RE::BGSSoundDescriptorForm *_parrySound_shd;
 	RE::BGSSoundDescriptorForm *_parrySound_wpn;
+	std::thread::id _mainThread;  // thread that ran init().
 	float _GMST_fCombatHitConeAngle;
 	float _parryAngle;
 
-	std::shared_mutex mtx_parryCostQueue;
-	std::shared_mutex mtx_parrySuccessActors;
-	std::shared_mutex mtx_parryTimer;
-
-	bool _bUpdate;
+	RE::BSFixedString _meleeParryEventName;
+	RE::BSFixedString _rangedParryEventName;
+	RE::BSFixedString _emptyString;
 };
 
@@ -0,0 +1,119 @@
+#include "Hitstop.h"
+#include "Settings.h"
+#include "Utils.hpp"
+
+namespace
+{
+	float smoothstep(float a_t)
+	{
+		a_t = std::clamp(a_t, 0.0f, 1.0f);
+		return a_t * a_t * (3.0f - 2.0f * a_t);
+	}
+}
+
+float Hitstop::Request::currentScale() const
+{
+	float weight = 1.0f;
+	if (easeIn > 0.0f && elapsed < easeIn) {
+		weight = smoothstep(elapsed / easeIn);
+	}
+	float remaining = duration - elapsed;
+	if (easeOut > 0.0f && remaining < easeOut) {
+		weight = (std::min)(weight, smoothstep(remaining / easeOut));
+	}
+	return 1.0f + (timeScale - 1.0f) * weight;
+}
+
+void Hitstop::request(float a_duration, float a_timeScale, std::int32_t a_priority, float a_easeIn, float a_easeOut)
+{
+	if (a_duration <= 0.0f) {
+		return;
+	}
+	Request request;
+	request.duration = a_duration;
+	request.timeScale = a_timeScale;
+	request.priority = a_priority;
+	request.easeIn = (std::min)(a_easeIn, a_duration);
+	request.easeOut = (std::min)(a_easeOut, a_duration - request.easeIn);
+	request.active = true;
+
+	std::lock_guard<std::mutex> lock(_pendingLock);
+	if (_numPending < _pending.size()) {
+		_pending[_numPending++] = request;
+	} else {
+		_pending.back() = request;  // more requests than slots in a single frame: the latest one wins.
+	}
+}
+
+void Hitstop::insert(const Request& a_request)
+{
+	// take a free slot, or evict the lowest priority request closest to its end.
+	Request* target = nullptr;
+	for (auto& slot : _active) {
+		if (!slot.active) {
+			target = std::addressof(slot);
+			break;
+		}
+		if (!target || slot.priority < target->priority ||
+			(slot.priority == target->priority && slot.duration - slot.elapsed < target->duration - target->elapsed)) {
+			target = std::addressof(slot);
+		}
+	}
+	if (target->active && target->priority > a_request.priority) {
+		return;
+	}
+	*target = a_request;
+}
+
+void Hitstop::update(float a_realDelta)
+{
+	// real time runs on behind a menu that pauses the game; don't spend the dilations there.
+	if (auto ui = RE::UI::GetSingleton(); ui && ui->GameIsPaused()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_pendingLock);
+		for (std::size_t i = 0; i < _numPending; ++i) {
+			insert(_pending[i]);
+		}
+		_numPending = 0;
+	}
+
+	const Request* driver = nullptr;
+	float          scale = 1.0f;
+	for (auto& request : _active) {
+		if (!request.active) {
+			continue;
+		}
+		request.elapsed += a_realDelta;
+		if (request.elapsed >= request.duration) {
+			request.active = false;
+			continue;
+		}
+		float requestScale = request.currentScale();
+		if (!driver || request.priority > driver->priority || (request.priority == driver->priority && requestScale < scale)) {
+			driver = std::addressof(request);
+			scale = requestScale;
+		}
+	}
+
+	if (std::abs(scale - _appliedScale) > 1e-3f || (scale == 1.0f && _appliedScale != 1.0f)) {
+		Utils::BSTimer_SetGlobalTimeMultiplier(Utils::BSTimer_GetSingleton(), scale);
+		_appliedScale = scale;
+	}
+}
+
+void Hitstop::reset()
+{
+	{
+		std::lock_guard<std::mutex> lock(_pendingLock);
+		_numPending = 0;
+	}
+	for (auto& request : _active) {
+		request.active = false;
+	}
+	if (_appliedScale != 1.0f) {
+		Utils::BSTimer_SetGlobalTimeMultiplier(Utils::BSTimer_GetSingleton(), 1.0f);
+		_appliedScale = 1.0f;
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <mutex>
+
+/*Time dilation driven from the main thread's update.
+Requests can be made from any thread; they are stacked and the one with the highest priority drives the
+global time multiplier (the strongest slowdown wins a tie). Each request eases in and out of its time scale.
+No thread is ever created and the per-frame cost only depends on the fixed number of request slots.*/
+class Hitstop
+{
+public:
+	static Hitstop* GetSingleton()
+	{
+		static Hitstop singleton;
+		return std::addressof(singleton);
+	}
+
+	/*Request a time dilation.
+	@param a_duration: real-time duration of the dilation, easing included.
+	@param a_timeScale: relative time speed to normal time(1).
+	@param a_priority: requests with a higher priority override lower ones while active.
+	@param a_easeIn: real-time seconds to blend from normal time to a_timeScale.
+	@param a_easeOut: real-time seconds to blend from a_timeScale back to normal time.*/
+	void request(float a_duration, float a_timeScale, std::int32_t a_priority = 0, float a_easeIn = 0.0f, float a_easeOut = 0.05f);
+
+	/*Advance all requests and apply the resulting time multiplier. Main thread only.
+	Requests are frozen while a menu pauses the game, and resume where they were once it closes.
+	@param a_realDelta: real time elapsed since the previous update.*/
+	void update(float a_realDelta);
+
+	/*Drop all requests and restore normal time. Main thread only.*/
+	void reset();
+
+private:
+	struct Request
+	{
+		float        duration{ 0.0f };
+		float        timeScale{ 1.0f };
+		float        easeIn{ 0.0f };
+		float        easeOut{ 0.0f };
+		float        elapsed{ 0.0f };
+		std::int32_t priority{ 0 };
+		bool         active{ false };
+
+		float currentScale() const;
+	};
+
+	static constexpr std::size_t MAX_REQUESTS = 8;
+
+	void insert(const Request& a_request);
+
+	std::array<Request, MAX_REQUESTS> _active;
+	std::array<Request, MAX_REQUESTS> _pending;
+	std::size_t                       _numPending{ 0 };
+	std::mutex                        _pendingLock;
+	float                             _appliedScale{ 1.0f };
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "PCH.h"
 #include "EldenParry.h"
+#include "LatencyStats.h"
 #include "Settings.h"
 #include "Utils.hpp"
 namespace Hooks
@@ -19,7 +20,7 @@ namespace Hooks
 
 	private:
 		static float getAttackStaminaCost(uintptr_t avOwner, RE::BGSAttackData* atkData) {
-			if (atkData->data.flags.any(RE::AttackData::AttackFlag::kBashAttack)) {
+			if (Settings::get().bSuccessfulParryNoCost && atkData->data.flags.any(RE::AttackData::AttackFlag::kBashAttack)) {
 				EldenParry::GetSingleton()->cacheParryCost((RE::Actor*)(avOwner - 0xB0), _getAttackStaminaCost(avOwner, atkData));
 				return 0;
 			}
@@ -42,28 +43,30 @@ namespace Hooks
 	private:
 		static bool shouldIgnoreHit(RE::Actor* a_aggressor, RE::Actor* a_victim)
 		{
+			const auto& settings = Settings::get();
 			//for aggressor: cancle parry hitframe.
 			
 			if (a_aggressor->AsActorState()->GetAttackState() == RE::ATTACK_STATE_ENUM::kBash) {
 				bool isAggressorShieldEquipped = Utils::isEquippedShield(a_aggressor);
 				if (!inlineUtils::isPowerAttacking(a_aggressor)) {
-					if (a_aggressor->IsPlayerRef() || Settings::bEnableNPCParry) {
-						if ((isAggressorShieldEquipped && Settings::bEnableShieldParry) || Settings::bEnableWeaponParry) {
+					if (a_aggressor->IsPlayerRef() || settings.bEnableNPCParry) {
+						if ((isAggressorShieldEquipped && settings.bEnableShieldParry) || settings.bEnableWeaponParry) {
 							return true;
 						} 
 					}
 				} else {//is power bash
-					if (a_aggressor->IsPlayerRef() || Settings::bEnableNPCParry) {
-						if ((isAggressorShieldEquipped && Settings::bEnableShieldGuardBash) || Settings::bEnableWeaponGuardBash) {
+					if (a_aggressor->IsPlayerRef() || settings.bEnableNPCParry) {
+						if ((isAggressorShieldEquipped && settings.bEnableShieldGuardBash) || settings.bEnableWeaponGuardBash) {
 							EldenParry::GetSingleton()->processGuardBash(a_aggressor, a_victim);
 						} 
 					}
 				}
 				
-			} else if (a_victim->AsActorState()->GetAttackState() == RE::ATTACK_STATE_ENUM::kBash) {
-				if (a_victim->IsPlayerRef() || Settings::bEnableNPCParry) {
+			} else if (EldenParry::GetSingleton()->hasActiveParriers() &&  //nobody is timing a parry: nothing to parry.
+					   a_victim->AsActorState()->GetAttackState() == RE::ATTACK_STATE_ENUM::kBash) {
+				if (a_victim->IsPlayerRef() || settings.bEnableNPCParry) {
 					bool isDefenderShieldEquipped = Utils::isEquippedShield(a_victim);
-					if ((isDefenderShieldEquipped && Settings::bEnableShieldParry) || Settings::bEnableWeaponParry) {
+					if ((isDefenderShieldEquipped && settings.bEnableShieldParry) || settings.bEnableWeaponParry) {
 						return EldenParry::GetSingleton()->processMeleeParry(a_aggressor, a_victim);
 					}
 				}
@@ -72,7 +75,12 @@ namespace Hooks
 		}
 		static void processHit(RE::Actor* a_aggressor, RE::Actor* a_victim, std::int64_t a_int1, bool a_bool, void* a_unkptr)
 		{
-			if (shouldIgnoreHit(a_aggressor, a_victim)) {
+			bool ignoreHit;
+			{
+				LatencyScope latency(LatencyProbe::kMeleeHit);
+				ignoreHit = shouldIgnoreHit(a_aggressor, a_victim);
+			}
+			if (ignoreHit) {
 				return;
 			}
 			_ProcessHit(a_aggressor, a_victim, a_int1, a_bool, a_unkptr);
@@ -120,34 +128,101 @@ namespace Hooks
 			_missileCollission = missileProjectileVtbl.write_vfunc(190, OnMissileCollision);
 		};
 
+		/*Counters of the contact pre-pass, to see how much work it saves.*/
+		struct ContactStats
+		{
+			std::atomic<std::uint64_t> contacts{ 0 };           // collidables seen in contact points.
+			std::atomic<std::uint64_t> skippedByLayer{ 0 };     // discarded because their layer can't be an actor.
+			std::atomic<std::uint64_t> skippedAsDuplicate{ 0 }; // discarded because their body was already evaluated.
+		};
+
+		static void logContactStats()
+		{
+			logger::info("Projectile contacts: {} seen, {} skipped by layer, {} skipped as duplicate.",
+				_contactStats.contacts.load(std::memory_order_relaxed),
+				_contactStats.skippedByLayer.load(std::memory_order_relaxed),
+				_contactStats.skippedAsDuplicate.load(std::memory_order_relaxed));
+		}
+
 	private:
+		static bool isActiveParrier(RE::TESObjectREFR* a_refr)
+		{
+			return a_refr && a_refr->formType == RE::FormType::ActorCharacter && EldenParry::GetSingleton()->isActiveParrier(a_refr->As<RE::Actor>());
+		}
+
+		static bool isActorLayer(const RE::hkpCollidable* a_collidable)
+		{
+			const auto layer = static_cast<RE::COL_LAYER>(a_collidable->broadPhaseHandle.collisionFilterInfo & 0x7F);
+			return layer == RE::COL_LAYER::kCharController || layer == RE::COL_LAYER::kBiped || layer == RE::COL_LAYER::kBipedNoCC;
+		}
+
 		static bool shouldIgnoreHit(RE::Projectile* a_projectile, RE::hkpAllCdPointCollector* a_AllCdPointCollector)
 		{
-			if (a_AllCdPointCollector) {
-				for (auto& hit : a_AllCdPointCollector->hits) {
-					auto refrA = RE::TESHavokUtilities::FindCollidableRef(*hit.rootCollidableA);
-					auto refrB = RE::TESHavokUtilities::FindCollidableRef(*hit.rootCollidableB);
-					if (refrA && refrA->formType == RE::FormType::ActorCharacter && refrA->As<RE::Actor>()->AsActorState()->GetAttackState() == RE::ATTACK_STATE_ENUM::kBash) {
-						if (refrA->IsPlayerRef() || Settings::bEnableNPCParry) {
-							if ((a_projectile->GetProjectileRuntimeData().spell && Settings::bEnableMagicProjectileDeflection) || Settings::bEnableArrowProjectileDeflection) {
-								return EldenParry::GetSingleton()->processProjectileParry(refrA->As<RE::Actor>(), a_projectile, const_cast<RE::hkpCollidable*>(hit.rootCollidableB));
-							}
-						}
+			//nobody is bashing: skip resolving the contacts.
+			if (!a_AllCdPointCollector || !EldenParry::GetSingleton()->hasActiveParriers()) {
+				return false;
+			}
+			const auto& settings = Settings::get();
+			if (!((a_projectile->GetProjectileRuntimeData().spell && settings.bEnableMagicProjectileDeflection) || settings.bEnableArrowProjectileDeflection)) {
+				return false;
+			}
+
+			//one projectile can touch the same body at many points: evaluate each body once.
+			std::array<const RE::hkpCollidable*, 8> evaluated{};
+			std::size_t numEvaluated = 0;
+			auto firstVisit = [&](const RE::hkpCollidable* a_collidable) {
+				for (std::size_t i = 0; i < numEvaluated; ++i) {
+					if (evaluated[i] == a_collidable) {
+						return false;
+					}
+				}
+				if (numEvaluated < evaluated.size()) {
+					evaluated[numEvaluated++] = a_collidable;
+				}
+				return true;
+			};
+
+			std::uint64_t contacts = 0, skippedByLayer = 0, skippedAsDuplicate = 0;
+			std::optional<bool> result;
+			for (auto& hit : a_AllCdPointCollector->hits) {
+				const std::pair<const RE::hkpCollidable*, const RE::hkpCollidable*> sides[] = {
+					{ hit.rootCollidableA, hit.rootCollidableB },
+					{ hit.rootCollidableB, hit.rootCollidableA },
+				};
+				for (const auto& [collidable, other] : sides) {
+					++contacts;
+					if (!isActorLayer(collidable)) {
+						++skippedByLayer;
+						continue;
 					}
-					if (refrB && refrB->formType == RE::FormType::ActorCharacter && refrB->As<RE::Actor>()->AsActorState()->GetAttackState() == RE::ATTACK_STATE_ENUM::kBash) {
-						if (refrB->IsPlayerRef() || Settings::bEnableNPCParry) {
-							if ((a_projectile->GetProjectileRuntimeData().spell && Settings::bEnableMagicProjectileDeflection) || Settings::bEnableArrowProjectileDeflection) {
-								return EldenParry::GetSingleton()->processProjectileParry(refrB->As<RE::Actor>(), a_projectile, const_cast<RE::hkpCollidable*>(hit.rootCollidableA));
-							}
-						}
+					if (!firstVisit(collidable)) {
+						++skippedAsDuplicate;
+						continue;
 					}
+					auto refr = RE::TESHavokUtilities::FindCollidableRef(*collidable);
+					if (isActiveParrier(refr) && (refr->IsPlayerRef() || settings.bEnableNPCParry)) {
+						result = EldenParry::GetSingleton()->processProjectileParry(refr->As<RE::Actor>(), a_projectile, const_cast<RE::hkpCollidable*>(other));
+						break;
+					}
+				}
+				if (result) {
+					break;
 				}
 			}
-			return false;
+
+			_contactStats.contacts.fetch_add(contacts, std::memory_order_relaxed);
+			_contactStats.skippedByLayer.fetch_add(skippedByLayer, std::memory_order_relaxed);
+			_contactStats.skippedAsDuplicate.fetch_add(skippedAsDuplicate, std::memory_order_relaxed);
+			return result.value_or(false);
 		}
 		static void OnArrowCollision(RE::Projectile* a_this, RE::hkpAllCdPointCollector* a_AllCdPointCollector)
 		{
-			if (shouldIgnoreHit(a_this, a_AllCdPointCollector)) {
+			bool ignoreHit;
+			{
+				LatencyScope latency(LatencyProbe::kArrowCollision);
+				ignoreHit = shouldIgnoreHit(a_this, a_AllCdPointCollector);
+			}
+			if (ignoreHit) {
 				return;
 			};
 			_arrowCollission(a_this, a_AllCdPointCollector);
@@ -155,13 +230,19 @@ namespace Hooks
 
 		static void OnMissileCollision(RE::Projectile* a_this, RE::hkpAllCdPointCollector* a_AllCdPointCollector)
 		{
-			if (shouldIgnoreHit(a_this, a_AllCdPointCollector)) {
+			bool ignoreHit;
+			{
+				LatencyScope latency(LatencyProbe::kMissileCollision);
+				ignoreHit = shouldIgnoreHit(a_this, a_AllCdPointCollector);
+			}
+			if (ignoreHit) {
 				return;
 			};
 			_missileCollission(a_this, a_AllCdPointCollector);
 		}
 		static inline REL::Relocation<decltype(OnArrowCollision)> _arrowCollission;
 		static inline REL::Relocation<decltype(OnMissileCollision)> _missileCollission;
+		static inline ContactStats _contactStats;
 	};
 
 	class PlayerUpdate  //no longer used
@@ -190,9 +271,7 @@ namespace Hooks
 	{
 		//SKSE::AllocTrampoline(1 << 4);
 		SKSE::AllocTrampoline(1 << 5);
-		if (Settings::bSuccessfulParryNoCost) {
-			Hook_getAttackStaminaCost::install();
-		}
+		Hook_getAttackStaminaCost::install();
 		PlayerUpdate::install();
 		MeleeCollision::install();
 		ProjectileCollision::install();
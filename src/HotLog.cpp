@@ -0,0 +1,35 @@
+#include "HotLog.h"
+
+void HotLog::start()
+{
+	if (_writer.joinable()) {
+		return;
+	}
+	_writer = std::jthread([this](std::stop_token a_stop) {
+		while (!a_stop.stop_requested()) {
+			std::this_thread::sleep_for(100ms);
+			drain();
+		}
+		drain();
+	});
+}
+
+void HotLog::drain()
+{
+	auto logger = spdlog::default_logger_raw();
+	bool wrote = false;
+	Entry entry;
+	while (_queue.pop(entry)) {
+		logger->log(entry.level, std::string_view(entry.text, entry.length));
+		wrote = true;
+	}
+	auto dropped = _dropped.load(std::memory_order_relaxed);
+	if (dropped != _reportedDropped) {
+		logger->warn("Hot path log ring full: {} messages dropped.", dropped - _reportedDropped);
+		_reportedDropped = dropped;
+		wrote = true;
+	}
+	if (wrote) {
+		logger->flush();
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <format>
+#include <thread>
+
+#include "ParryCore/MPSCQueue.h"
+
+// Hot path messages below this level are compiled out. Uses spdlog's SPDLOG_LEVEL_* values.
+#ifndef EP_HOTLOG_LEVEL
+#	ifdef NDEBUG
+#		define EP_HOTLOG_LEVEL SPDLOG_LEVEL_INFO
+#	else
+#		define EP_HOTLOG_LEVEL SPDLOG_LEVEL_TRACE
+#	endif
+#endif
+
+#define EP_HOTLOG(a_level, a_spdlogLevel, ...)                                    \
+	do {                                                                          \
+		if constexpr (a_level >= EP_HOTLOG_LEVEL) {                               \
+			HotLog::GetSingleton()->write(spdlog::level::a_spdlogLevel, __VA_ARGS__); \
+		}                                                                         \
+	} while (0)
+
+#define HOTLOG_TRACE(...) EP_HOTLOG(SPDLOG_LEVEL_TRACE, trace, __VA_ARGS__)
+#define HOTLOG_DEBUG(...) EP_HOTLOG(SPDLOG_LEVEL_DEBUG, debug, __VA_ARGS__)
+#define HOTLOG_INFO(...) EP_HOTLOG(SPDLOG_LEVEL_INFO, info, __VA_ARGS__)
+#define HOTLOG_WARN(...) EP_HOTLOG(SPDLOG_LEVEL_WARN, warn, __VA_ARGS__)
+
+/*Logging for hot paths (collision hooks, anim events).
+Messages are formatted into a fixed-size record on the calling thread without allocating, pushed to a
+preallocated ring and written to the log by a background thread. A full ring drops messages instead of blocking.*/
+class HotLog
+{
+public:
+	static HotLog* GetSingleton()
+	{
+		static HotLog singleton;
+		return std::addressof(singleton);
+	}
+
+	/*Start the background writer. Call once the default logger is set up.*/
+	void start();
+
+	template <class... Args>
+	void write(spdlog::level::level_enum a_level, std::format_string<Args...> a_fmt, Args&&... a_args)
+	{
+		Entry entry;
+		entry.level = a_level;
+		auto result = std::format_to_n(entry.text, sizeof(entry.text), a_fmt, std::forward<Args>(a_args)...);
+		entry.length = static_cast<std::uint16_t>((std::min)(static_cast<std::size_t>(result.size), sizeof(entry.text)));
+		if (!_queue.push(entry)) {
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct Entry
+	{
+		spdlog::level::level_enum level{ spdlog::level::info };
+		std::uint16_t             length{ 0 };
+		char                      text[240];
+	};
+
+	HotLog() = default;
+
+	void drain();
+
+	MPSCQueue<Entry, 512>      _queue;
+	std::atomic<std::uint64_t> _dropped{ 0 };
+	std::uint64_t              _reportedDropped{ 0 };
+	std::jthread               _writer;
+};
@@ -0,0 +1,126 @@
+#include "LatencyStats.h"
+#include "ParryClock.h"
+#include "Settings.h"
+
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+	constexpr std::array<std::string_view, static_cast<std::size_t>(LatencyProbe::kTotal)> probeNames{
+		"MeleeCollision::processHit"sv,
+		"ProjectileCollision::OnArrowCollision"sv,
+		"ProjectileCollision::OnMissileCollision"sv,
+		"animEventHandler::ProcessAnimEvent"sv,
+		"EldenParry::precisionPrehitCallbackFunc"sv,
+		"EldenParry::update"sv,
+		"NPCParryAI::update"sv,
+		"EldenParry::precisionPrePhysicsStepCallbackFunc"sv,
+	};
+}
+
+void LatencyStats::start()
+{
+	_enabled = Settings::get().bEnableLatencyStats;
+	if (!_enabled) {
+		return;
+	}
+	_startTicks = ticks();
+	_startTime = ParryClock::realNow();
+	_nextDump = _startTime + Settings::get().fLatencyDumpInterval;
+	logger::info("Latency stats enabled.");
+}
+
+LatencyStats::ThreadHistograms* LatencyStats::registerThread()
+{
+	std::lock_guard<std::mutex> lock(_threadsLock);
+	return _threads.emplace_back(std::make_unique<ThreadHistograms>()).get();
+}
+
+double LatencyStats::ticksPerMicrosecond() const
+{
+	double elapsed = ParryClock::realNow() - _startTime;
+	if (elapsed <= 0.0) {
+		return 0.0;
+	}
+	return static_cast<double>(ticks() - _startTicks) / (elapsed * 1e6);
+}
+
+void LatencyStats::update()
+{
+	if (!_enabled || Settings::get().fLatencyDumpInterval <= 0.0f) {
+		return;
+	}
+	double now = ParryClock::realNow();
+	if (now < _nextDump) {
+		return;
+	}
+	_nextDump = now + Settings::get().fLatencyDumpInterval;
+	dump();
+}
+
+void LatencyStats::dump()
+{
+	if (!_enabled) {
+		return;
+	}
+	auto path = logger::log_directory();
+	if (!path) {
+		return;
+	}
+	*path /= "EldenParry_latency.csv"sv;
+
+	const double tpus = ticksPerMicrosecond();
+	if (tpus <= 0.0) {
+		return;
+	}
+
+	std::vector<std::uint64_t> merged(BUCKETS);
+	std::ofstream file(*path, std::ios::trunc);
+	if (!file) {
+		logger::error("Failed to write latency stats to {}", path->string());
+		return;
+	}
+	file << "probe,count,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n";
+
+	std::lock_guard<std::mutex> lock(_threadsLock);
+	for (std::size_t probe = 0; probe < probeNames.size(); ++probe) {
+		std::ranges::fill(merged, 0);
+		std::uint64_t count = 0, total = 0, max = 0;
+		for (auto& thread : _threads) {
+			auto& histogram = thread->probes[probe];
+			for (std::uint32_t i = 0; i < BUCKETS; ++i) {
+				merged[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+			}
+			count += histogram.count.load(std::memory_order_relaxed);
+			total += histogram.total.load(std::memory_order_relaxed);
+			max = (std::max)(max, histogram.max.load(std::memory_order_relaxed));
+		}
+
+		// recount from the buckets: a thread may be mid-record while we read its count.
+		std::uint64_t bucketed = 0;
+		for (auto n : merged) {
+			bucketed += n;
+		}
+		auto percentile = [&](double a_fraction) {
+			auto rank = static_cast<std::uint64_t>(std::ceil(a_fraction * static_cast<double>(bucketed)));
+			std::uint64_t seen = 0;
+			for (std::uint32_t i = 0; i < BUCKETS; ++i) {
+				seen += merged[i];
+				if (seen >= rank && seen > 0) {
+					// report the bucket's upper edge: percentiles are never underestimated.
+					auto upper = i + 1 < BUCKETS ? bucketFloor(i + 1) : max;
+					return static_cast<double>((std::min)(upper, max)) / tpus;
+				}
+			}
+			return 0.0;
+		};
+
+		double mean = count ? static_cast<double>(total) / static_cast<double>(count) / tpus : 0.0;
+		file << std::format("{},{},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f},{:.3f}\n",
+			probeNames[probe], count, mean,
+			percentile(0.5), percentile(0.9), percentile(0.99), percentile(0.999),
+			static_cast<double>(max) / tpus);
+	}
+	logger::info("Latency stats written to {}", path->string());
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <intrin.h>
+
+/*Code paths whose latency is tracked.*/
+enum class LatencyProbe : std::uint32_t
+{
+	kMeleeHit,
+	kArrowCollision,
+	kMissileCollision,
+	kAnimEvent,
+	kPrecisionPrehit,
+	kUpdate,
+	kNPCParryAI,
+	kPrePhysicsStep,
+	kTotal
+};
+
+/*Latency histograms of the hooks, in TSC ticks.
+Each thread records into its own histograms, so recording is a few plain stores with no shared cache line.
+Histograms are log-linear (HDR style): 16 linear sub-buckets per power of two, i.e. about 6% precision at any magnitude.
+They are merged on demand and written to EldenParry_latency.csv in the log directory, on save and optionally on a timer.*/
+class LatencyStats
+{
+public:
+	static LatencyStats* GetSingleton()
+	{
+		static LatencyStats singleton;
+		return std::addressof(singleton);
+	}
+
+	static std::uint64_t ticks() { return __rdtsc(); }
+
+	/*Start recording if enabled in the settings. Anchors the TSC calibration.*/
+	void start();
+
+	bool enabled() const { return _enabled; }
+
+	void record(LatencyProbe a_probe, std::uint64_t a_ticks)
+	{
+		if (!_local) {
+			_local = registerThread();
+		}
+		_local->probes[static_cast<std::size_t>(a_probe)].add(a_ticks);
+	}
+
+	/*Dump the histograms when the dump interval has elapsed. Main thread, once per frame.*/
+	void update();
+
+	/*Merge the histograms of all threads and write them to the csv file.*/
+	void dump();
+
+private:
+	static constexpr std::uint32_t SUB_BITS = 4;
+	static constexpr std::uint32_t SUB_BUCKETS = 1 << SUB_BITS;
+	static constexpr std::uint32_t MAX_EXPONENT = 47;  // ~13 hours at 6 GHz; anything longer lands in the last bucket.
+	static constexpr std::uint32_t BUCKETS = (MAX_EXPONENT - SUB_BITS + 2) * SUB_BUCKETS;
+
+	static std::uint32_t bucketOf(std::uint64_t a_ticks)
+	{
+		if (a_ticks < SUB_BUCKETS) {
+			return static_cast<std::uint32_t>(a_ticks);
+		}
+		auto exponent = static_cast<std::uint32_t>(std::bit_width(a_ticks)) - 1;
+		if (exponent > MAX_EXPONENT) {
+			return BUCKETS - 1;
+		}
+		auto sub = static_cast<std::uint32_t>(a_ticks >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+		return (exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+	}
+
+	/*Smallest value falling in the bucket.*/
+	static std::uint64_t bucketFloor(std::uint32_t a_bucket)
+	{
+		if (a_bucket < SUB_BUCKETS) {
+			return a_bucket;
+		}
+		auto exponent = a_bucket / SUB_BUCKETS + SUB_BITS - 1;
+		auto sub = a_bucket % SUB_BUCKETS;
+		return static_cast<std::uint64_t>(SUB_BUCKETS + sub) << (exponent - SUB_BITS);
+	}
+
+	/*Written by its owning thread only; atomics let dump() read it concurrently without tearing.*/
+	struct Histogram
+	{
+		std::array<std::atomic<std::uint64_t>, BUCKETS> buckets{};
+		std::atomic<std::uint64_t>                      count{ 0 };
+		std::atomic<std::uint64_t>                      total{ 0 };
+		std::atomic<std::uint64_t>                      max{ 0 };
+
+		void add(std::uint64_t a_ticks)
+		{
+			bump(buckets[bucketOf(a_ticks)], 1);
+			bump(count, 1);
+			bump(total, a_ticks);
+			if (a_ticks > max.load(std::memory_order_relaxed)) {
+				max.store(a_ticks, std::memory_order_relaxed);
+			}
+		}
+
+		static void bump(std::atomic<std::uint64_t>& a_counter, std::uint64_t a_amount)
+		{
+			a_counter.store(a_counter.load(std::memory_order_relaxed) + a_amount, std::memory_order_relaxed);
+		}
+	};
+
+	struct ThreadHistograms
+	{
+		std::array<Histogram, static_cast<std::size_t>(LatencyProbe::kTotal)> probes;
+	};
+
+	LatencyStats() = default;
+
+	ThreadHistograms* registerThread();
+
+	/*TSC ticks per microsecond, measured against the steady clock since start().*/
+	double ticksPerMicrosecond() const;
+
+	static inline thread_local ThreadHistograms* _local = nullptr;
+
+	bool                                           _enabled{ false };
+	std::uint64_t                                  _startTicks{ 0 };
+	double                                         _startTime{ 0.0 };
+	double                                         _nextDump{ 0.0 };
+	std::mutex                                     _threadsLock;
+	std::vector<std::unique_ptr<ThreadHistograms>> _threads;  // never shrinks: a thread's histograms outlive it.
+};
+
+/*Records the time spent in the enclosing scope.*/
+class LatencyScope
+{
+public:
+	explicit LatencyScope(LatencyProbe a_probe) :
+		_probe(a_probe),
+		_start(LatencyStats::GetSingleton()->enabled() ? LatencyStats::ticks() : 0)
+	{}
+
+	~LatencyScope()
+	{
+		if (_start) {
+			LatencyStats::GetSingleton()->record(_probe, LatencyStats::ticks() - _start);
+		}
+	}
+
+	LatencyScope(const LatencyScope&) = delete;
+	LatencyScope& operator=(const LatencyScope&) = delete;
+
+private:
+	LatencyProbe  _probe;
+	std::uint64_t _start;
+};
@@ -0,0 +1,88 @@
+#include "ModAPI.h"
+#include "EldenParry.h"
+
+namespace Messaging
+{
+	static_assert(std::to_underlying(EP_API::StaggerTier::DefenderLarge) == std::to_underlying(ParryCore::StaggerTier::kDefenderLarge) &&
+				  std::to_underlying(EP_API::StaggerTier::AttackerLarge) == std::to_underlying(ParryCore::StaggerTier::kAttackerLarge));
+
+	APIResult EldenParryInterface::AddParryCallback(SKSE::PluginHandle a_myPluginHandle, EP_API::ParryCallback&& a_parryCallback) noexcept
+	{
+		std::unique_lock lock(_lock);
+		auto it = std::ranges::find(_parryCallbacks, a_myPluginHandle, &std::pair<SKSE::PluginHandle, EP_API::ParryCallback>::first);
+		if (it != _parryCallbacks.end()) {
+			return APIResult::AlreadyRegistered;
+		}
+		_parryCallbacks.emplace_back(a_myPluginHandle, std::move(a_parryCallback));
+		_hasParryCallbacks.store(true, std::memory_order_release);
+		return APIResult::OK;
+	}
+
+	APIResult EldenParryInterface::RemoveParryCallback(SKSE::PluginHandle a_myPluginHandle) noexcept
+	{
+		std::unique_lock lock(_lock);
+		if (!std::erase_if(_parryCallbacks, [a_myPluginHandle](const auto& a_entry) { return a_entry.first == a_myPluginHandle; })) {
+			return APIResult::NotRegistered;
+		}
+		_hasParryCallbacks.store(!_parryCallbacks.empty(), std::memory_order_release);
+		return APIResult::OK;
+	}
+
+	bool EldenParryInterface::IsInParryWindow(RE::Actor* a_actor) const noexcept
+	{
+		return a_actor && EldenParry::GetSingleton()->parryWindowRemaining(a_actor) > 0.0;
+	}
+
+	float EldenParryInterface::GetParryWindowRemaining(RE::Actor* a_actor) const noexcept
+	{
+		return a_actor ? static_cast<float>(EldenParry::GetSingleton()->parryWindowRemaining(a_actor)) : 0.0f;
+	}
+
+	double EldenParryInterface::GetRiposteScore(RE::Actor* a_actor) noexcept
+	{
+		return a_actor ? EldenParry::GetSingleton()->queryScore(a_actor) : 0.0;
+	}
+
+	EP_API::StaggerTier EldenParryInterface::PredictStaggerTier(RE::Actor* a_parrier, RE::Actor* a_attacker) noexcept
+	{
+		if (!a_parrier || !a_attacker) {
+			return EP_API::StaggerTier::Attacker;
+		}
+		return static_cast<EP_API::StaggerTier>(EldenParry::GetSingleton()->predictStaggerTier(a_parrier, a_attacker));
+	}
+
+	void EldenParryInterface::dispatchParry(const EP_API::ParryEventData& a_data) const
+	{
+		// run the callbacks on a copy, outside of the lock, so they may add or remove callbacks themselves.
+		std::vector<EP_API::ParryCallback> callbacks;
+		{
+			std::shared_lock lock(_lock);
+			callbacks.reserve(_parryCallbacks.size());
+			for (const auto& [handle, callback] : _parryCallbacks) {
+				callbacks.push_back(callback);
+			}
+		}
+		for (const auto& callback : callbacks) {
+			callback(a_data);
+		}
+	}
+}
+
+extern "C" DLLEXPORT void* SKSEAPI RequestPluginAPI(const EP_API::InterfaceVersion a_interfaceVersion)
+{
+	auto api = Messaging::EldenParryInterface::GetSingleton();
+
+	logger::info("EldenParry::RequestPluginAPI called, InterfaceVersion {}", static_cast<uint8_t>(a_interfaceVersion) + 1);
+
+	switch (a_interfaceVersion) {
+	case EP_API::InterfaceVersion::V1:
+		logger::info("EldenParry::RequestPluginAPI returned the API singleton");
+		return static_cast<void*>(static_cast<Messaging::InterfaceVersion1*>(api));
+	case EP_API::InterfaceVersion::V2:
+		logger::info("EldenParry::RequestPluginAPI returned the API singleton");
+		return static_cast<void*>(static_cast<Messaging::InterfaceVersion2*>(api));
+	}
+
+	logger::info("EldenParry::RequestPluginAPI requested the wrong interface version");
+	return nullptr;
+}
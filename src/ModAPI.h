@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <shared_mutex>
+#include <vector>
+
+#include "lib/EldenParryAPI.h"
+
+namespace Messaging
+{
+	using APIResult = ::EP_API::APIResult;
+	using InterfaceVersion1 = ::EP_API::IVEldenParry1;
+	using InterfaceVersion2 = ::EP_API::IVEldenParry2;
+
+	class EldenParryInterface : public InterfaceVersion2
+	{
+	private:
+		EldenParryInterface() noexcept = default;
+		virtual ~EldenParryInterface() noexcept = default;
+
+	public:
+		static EldenParryInterface* GetSingleton() noexcept
+		{
+			static EldenParryInterface singleton;
+			return std::addressof(singleton);
+		}
+
+		// InterfaceVersion1
+		virtual APIResult AddParryCallback(SKSE::PluginHandle a_myPluginHandle, EP_API::ParryCallback&& a_parryCallback) noexcept override;
+		virtual APIResult RemoveParryCallback(SKSE::PluginHandle a_myPluginHandle) noexcept override;
+
+		// InterfaceVersion2
+		virtual bool IsInParryWindow(RE::Actor* a_actor) const noexcept override;
+		virtual float GetParryWindowRemaining(RE::Actor* a_actor) const noexcept override;
+		virtual double GetRiposteScore(RE::Actor* a_actor) noexcept override;
+		virtual EP_API::StaggerTier PredictStaggerTier(RE::Actor* a_parrier, RE::Actor* a_attacker) noexcept override;
+
+		/*True if any plugin registered a parry callback. Lock-free; lets the parry paths skip building the event data.*/
+		bool hasParryCallbacks() const noexcept { return _hasParryCallbacks.load(std::memory_order_acquire); }
+
+		/*Run every registered parry callback. Any thread.*/
+		void dispatchParry(const EP_API::ParryEventData& a_data) const;
+
+	private:
+		mutable std::shared_mutex                                        _lock;
+		std::vector<std::pair<SKSE::PluginHandle, EP_API::ParryCallback>> _parryCallbacks;
+		std::atomic<bool>                                                _hasParryCallbacks{ false };
+	};
+}
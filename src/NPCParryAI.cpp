@@ -0,0 +1,158 @@
+#include "NPCParryAI.h"
+#include "CoreAdapter.h"
+#include "EldenParry.h"
+#include "HotLog.h"
+#include "LatencyStats.h"
+#include "ParryClock.h"
+
+#include <chrono>
+
+namespace
+{
+	bool isSwinging(RE::ATTACK_STATE_ENUM a_state)
+	{
+		return a_state == RE::ATTACK_STATE_ENUM::kSwing || a_state == RE::ATTACK_STATE_ENUM::kHit;
+	}
+
+	bool isWindingUp(RE::ATTACK_STATE_ENUM a_state)
+	{
+		return a_state == RE::ATTACK_STATE_ENUM::kDraw;
+	}
+}
+
+void NPCParryAI::init()
+{
+	//intern the animation events once, instead of on every bash
+	_blockStartEvent = "blockStart";
+	_bashStartEvent = "bashStart";
+}
+
+void NPCParryAI::update()
+{
+	const auto& settings = Settings::get();
+	if (!settings.bEnableNPCParryAI || !settings.bEnableNPCParry) {
+		return;
+	}
+	LatencyScope latency(LatencyProbe::kNPCParryAI);
+	const double now = ParryClock::gameNow();
+
+	issueBashes(now);
+	gather();
+	if (_combatants.empty()) {
+		return;
+	}
+	_hash.build(_positions, settings.fNPCParryAIRange);
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto budget = std::chrono::duration<float, std::milli>(settings.fNPCParryAIBudget);
+	for (std::size_t evaluated = 0; evaluated < _combatants.size(); ++evaluated) {
+		if (_cursor >= _combatants.size()) {
+			_cursor = 0;
+		}
+		auto index = _cursor++;
+		if (_combatants[index].canDefend) {
+			evaluate(index, now, settings);
+		}
+		if (std::chrono::steady_clock::now() - start >= budget) {
+			break;
+		}
+	}
+}
+
+void NPCParryAI::reset()
+{
+	_combatants.clear();
+	_positions.clear();
+	_defenders.clear();
+	_cursor = 0;
+}
+
+void NPCParryAI::gather()
+{
+	_combatants.clear();
+	_positions.clear();
+	auto add = [this](RE::Actor* a_actor) {
+		if (!a_actor->IsInCombat() || a_actor->IsDead() || !a_actor->Is3DLoaded()) {
+			return;
+		}
+		auto attackState = a_actor->AsActorState()->GetAttackState();
+		bool canDefend = !a_actor->IsPlayerRef() && attackState == RE::ATTACK_STATE_ENUM::kNone &&
+		                 (a_actor->GetEquippedObject(true) || a_actor->GetEquippedObject(false));
+		_combatants.push_back({ a_actor, CoreAdapter::poseOf(a_actor), attackState, canDefend });
+		_positions.push_back(_combatants.back().pose.position);
+	};
+	if (auto player = RE::PlayerCharacter::GetSingleton()) {
+		add(player);
+	}
+	if (auto processLists = RE::ProcessLists::GetSingleton()) {
+		for (auto& handle : processLists->highActorHandles) {
+			if (auto actor = handle.get().get()) {
+				add(actor);
+			}
+		}
+	}
+}
+
+void NPCParryAI::evaluate(std::size_t a_index, double a_now, const Settings::Config& a_settings)
+{
+	const auto& defender = _combatants[a_index];
+	auto& state = _defenders[defender.actor->GetHandle().native_handle()];
+	state.lastEvaluated = a_now;
+	if (state.bashPending || a_now < state.nextEvaluation) {
+		return;
+	}
+
+	const float parryAngle = EldenParry::GetSingleton()->parryAngle();
+	const Combatant* threat = nullptr;
+	_hash.query(defender.pose.position, a_settings.fNPCParryAIRange, [&](std::uint32_t a_other) {
+		const auto& attacker = _combatants[a_other];
+		if (a_other == a_index || !(isSwinging(attacker.attackState) || isWindingUp(attacker.attackState))) {
+			return;
+		}
+		// the swing must be aimed at the defender, and the defender must face it for the parry to count.
+		if (!ParryCore::inBlockAngle(attacker.pose, defender.pose.position, parryAngle) ||
+			!ParryCore::inBlockAngle(defender.pose, attacker.pose.position, parryAngle)) {
+			return;
+		}
+		if (!threat || (isSwinging(attacker.attackState) && !isSwinging(threat->attackState))) {
+			threat = std::addressof(attacker);
+		}
+	});
+	if (!threat) {
+		return;
+	}
+
+	state.nextEvaluation = a_now + DECISION_COOLDOWN;
+	double reprisal = a_settings.useScoreSystem ? EldenParry::GetSingleton()->AttackerBeatsParry(threat->actor, defender.actor) : 0.0;
+	float likelihood = ParryCore::parryLikelihood(a_settings.fNPCParryAIChance, reprisal);
+	if (std::uniform_real_distribution<float>(0.0f, 1.0f)(_rng) >= likelihood) {
+		return;
+	}
+
+	if (!defender.actor->IsBlocking()) {
+		defender.actor->NotifyAnimationGraph(_blockStartEvent);
+	}
+	state.bashPending = true;
+	state.bashAt = a_now + (isSwinging(threat->attackState) ? 0.0 : a_settings.fNPCParryAIReactionTime);
+	HOTLOG_DEBUG("NPC parry AI: {} will parry {}", defender.actor->GetName(), threat->actor->GetName());
+}
+
+void NPCParryAI::issueBashes(double a_now)
+{
+	for (auto it = _defenders.begin(); it != _defenders.end();) {
+		auto& [handle, state] = *it;
+		if (!state.bashPending) {
+			it = a_now - state.lastEvaluated > FORGET_AFTER ? _defenders.erase(it) : std::next(it);
+			continue;
+		}
+		if (a_now >= state.bashAt) {
+			state.bashPending = false;
+			state.nextEvaluation = a_now + DECISION_COOLDOWN;
+			auto actor = RE::Actor::LookupByHandle(handle);
+			if (actor && !actor->IsDead() && actor->AsActorState()->GetAttackState() == RE::ATTACK_STATE_ENUM::kNone) {
+				actor->NotifyAnimationGraph(_bashStartEvent);
+			}
+		}
+		++it;
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "ParryCore/SpatialHash.h"
+#include "Settings.h"
+
+/*Parry decisions for NPCs in combat.
+Once per frame the combatants are gathered into a spatial hash. NPCs are then evaluated round-robin until the frame's CPU
+budget is spent: each one looks up the swings coming at it from within reach and may commit to a bash, timed so that its
+parry window is open when the swing lands. With many combatants an NPC is evaluated every few frames instead of every frame.*/
+class NPCParryAI
+{
+public:
+	static NPCParryAI* GetSingleton()
+	{
+		static NPCParryAI singleton;
+		return std::addressof(singleton);
+	}
+
+	/*Intern the animation events sent to NPCs. Call once the game's string cache is up, e.g. on kDataLoaded.*/
+	void init();
+
+	/*Main thread, once per frame.*/
+	void update();
+
+	/*Forget all pending decisions, e.g. before a save is loaded. Main thread only.*/
+	void reset();
+
+private:
+	static constexpr double DECISION_COOLDOWN = 0.6;  // seconds before an NPC reconsiders after committing to a decision.
+	static constexpr double FORGET_AFTER = 10.0;      // seconds after which an NPC that wasn't evaluated is forgotten.
+
+	struct Combatant
+	{
+		RE::Actor*      actor;
+		ParryCore::Pose pose;
+		RE::ATTACK_STATE_ENUM attackState;
+		bool            canDefend;  // an NPC that is not attacking and holds something to bash with.
+	};
+
+	struct Defender
+	{
+		double lastEvaluated{ 0.0 };
+		double nextEvaluation{ 0.0 };
+		double bashAt{ 0.0 };
+		bool   bashPending{ false };
+	};
+
+	void gather();
+	/*Look for a swing coming at the NPC and decide whether to parry it.*/
+	void evaluate(std::size_t a_index, double a_now, const Settings::Config& a_settings);
+	/*Send the bashes whose time came.*/
+	void issueBashes(double a_now);
+
+	std::vector<Combatant>                      _combatants;
+	std::vector<ParryCore::Vec3>                _positions;
+	ParryCore::SpatialHash                      _hash;
+	std::unordered_map<std::uint32_t, Defender> _defenders;  // keyed by the native handle of the NPC.
+	std::size_t                                 _cursor{ 0 };
+	std::minstd_rand                            _rng{ std::random_device{}() };
+	RE::BSFixedString                           _blockStartEvent;
+	RE::BSFixedString                           _bashStartEvent;
+};
@@ -0,0 +1,125 @@
+#include "ParryBenchmark.h"
+#include "AnimEventHandler.h"
+#include "EldenParry.h"
+#include "ParryClock.h"
+#include "Settings.h"
+
+#include "Utils.hpp"
+
+namespace
+{
+	constexpr std::array<std::size_t, 4> actorCounts{ 1, 4, 16, 64 };
+	constexpr std::size_t                ITERATIONS = 20000;
+
+	volatile double sink = 0.0;  // keeps the measured calls from being optimized out.
+
+	/*Average time of a_fn(i) over ITERATIONS calls, in nanoseconds.*/
+	template <class Fn>
+	double measure(Fn&& a_fn)
+	{
+		double accumulated = 0.0;
+		auto   start = std::chrono::steady_clock::now();
+		for (std::size_t i = 0; i < ITERATIONS; ++i) {
+			accumulated += a_fn(i);
+		}
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		sink = sink + accumulated;
+		return std::chrono::duration<double, std::nano>(elapsed).count() / ITERATIONS;
+	}
+
+	/*The player and the actors in high process, each once.*/
+	std::vector<RE::Actor*> gatherActors()
+	{
+		std::vector<RE::Actor*> actors;
+		if (auto player = RE::PlayerCharacter::GetSingleton()) {
+			actors.push_back(player);
+		}
+		if (auto processLists = RE::ProcessLists::GetSingleton()) {
+			for (auto& handle : processLists->highActorHandles) {
+				if (auto actor = handle.get().get(); actor && actor->Is3DLoaded()) {
+					actors.push_back(actor);
+				}
+			}
+		}
+		return actors;
+	}
+}
+
+void ParryBenchmark::run()
+{
+	auto available = gatherActors();
+	if (available.size() < 2) {
+		logger::warn("Benchmark skipped: needs at least 2 loaded actors, found {}.", available.size());
+		return;
+	}
+	logger::info("Benchmark: {} loaded actors, {} iterations per case.", available.size(), ITERATIONS);
+
+	auto eldenParry = EldenParry::GetSingleton();
+	auto& scoreSettings = Settings::get().scores;
+	const RE::BSFixedString unroutedTag{ "weaponSwing" };
+
+	for (auto count : actorCounts) {
+		// actors are reused in rotation when fewer are loaded than requested.
+		std::vector<RE::Actor*> actors(count);
+		for (std::size_t i = 0; i < count; ++i) {
+			actors[i] = available[i % available.size()];
+		}
+		auto actorAt = [&](std::size_t i) { return actors[i % count]; };
+		auto opponentOf = [&](std::size_t i) {
+			auto opponent = actors[(i + 1) % count];
+			return opponent != actorAt(i) ? opponent : available[(i + 1) % available.size()];
+		};
+
+		auto report = [count](std::string_view a_case, double a_nanoseconds) {
+			logger::info("Benchmark {:<24} {:>3} actors: {:>9.1f} ns/op", a_case, count, a_nanoseconds);
+		};
+
+		report("GetScore (cached)", measure([&](std::size_t i) {
+			return eldenParry->GetScore(actorAt(i), scoreSettings);
+		}));
+		report("GetScore (cold)", measure([&](std::size_t i) {
+			eldenParry->invalidateScore(actorAt(i));
+			return eldenParry->GetScore(actorAt(i), scoreSettings);
+		}));
+		report("AttackerBeatsParry", measure([&](std::size_t i) {
+			return eldenParry->AttackerBeatsParry(actorAt(i), opponentOf(i));
+		}));
+
+		ActorStateTable timers;
+		auto keyOf = [count](std::size_t i) { return static_cast<ActorStateTable::Key>(i % count + 1); };
+		report("parry timer start", measure([&](std::size_t i) {
+			double now = ParryClock::realNow();
+			timers.modify(keyOf(i), [now](ActorState& a_state) {
+				a_state.parryStart = now;
+				a_state.set(ActorState::kTimingParry);
+			}, now - 1.0);
+			return now;
+		}));
+		report("parry timer query", measure([&](std::size_t i) {
+			ActorState state;
+			return timers.find(keyOf(i), state) ? ParryClock::realNow() - state.parryStart : 0.0;
+		}));
+		report("parry timer finish", measure([&](std::size_t i) {
+			return timers.modify(keyOf(i), [](ActorState& a_state) {
+				a_state.clear(ActorState::kTimingParry);
+			}, 0.0) ? 1.0 : 0.0;
+		}));
+
+		report("anim event dispatch", measure([&](std::size_t i) {
+			RE::BSAnimationGraphEvent event{ unroutedTag, actorAt(i), RE::BSFixedString() };
+			animEventHandler::ProcessAnimEvent(std::addressof(event));
+			return 0.0;
+		}));
+
+		report("PredictAimProjectile", measure([&](std::size_t i) {
+			RE::NiPoint3 velocity{ 0.0f, 3000.0f, 0.0f };
+			auto hit = Utils::PredictAimProjectile(actorAt(i)->GetPosition(), opponentOf(i)->GetPosition(), { 50.0f, 0.0f, 0.0f }, 0.0f, velocity);
+			return hit ? static_cast<double>(velocity.x) : 0.0;
+		}));
+
+		report("inBlockAngle", measure([&](std::size_t i) {
+			return eldenParry->inBlockAngle(actorAt(i), opponentOf(i)) ? 1.0 : 0.0;
+		}));
+	}
+	logger::info("Benchmark done.");
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+/*In-game microbenchmark of the parry core, run against the actors loaded around the player.
+Each case is timed with 1 to 64 actors in rotation and the results are written to the log, so optimizations of
+these paths can be measured instead of guessed. Cases are chosen to be side-effect free: timer operations
+run on a private state table and anim events use a tag no route listens to.*/
+class ParryBenchmark
+{
+public:
+	/*Run all cases. Main thread, with a loaded game.*/
+	static void run();
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*Clock used to time parry windows.
+Real time is read straight from the steady clock, so slow time effects do not stretch the window.
+Game time follows the engine's scaled frame delta. It is anchored once per frame on the main thread
+and extrapolated with the last observed time scale, so it can be read at sub-frame precision from any thread.*/
+class ParryClock
+{
+public:
+	static double realNow()
+	{
+		using seconds = std::chrono::duration<double>;
+		return std::chrono::duration_cast<seconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static double gameNow()
+	{
+		return gameAt(realNow());
+	}
+
+	static double now(bool a_realTime)
+	{
+		return a_realTime ? realNow() : gameNow();
+	}
+
+	/*Re-anchor the game clock. Must only be called from the main thread, once per frame.
+	@param a_gameDelta: scaled time elapsed since the previous frame.*/
+	static void update(float a_gameDelta)
+	{
+		double real = realNow();
+		double game = gameAt(real);
+		double realDelta = real - _lastFrameReal;
+		double scale = realDelta > 0.0 ? std::clamp(a_gameDelta / realDelta, 0.0, MAX_SCALE) : 1.0;
+		_lastFrameReal = real;
+		if (realDelta > MAX_EXTRAPOLATION) {
+			// below 10 fps the extrapolation stopped short of the frame; catch up by the engine's delta, which the
+			// engine clamps itself. Never step back behind what readers already saw.
+			game = (std::max)(game, _anchorGame.load(std::memory_order_relaxed) + a_gameDelta);
+		}
+
+		auto seq = _seq.load(std::memory_order_relaxed);
+		_seq.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		_anchorReal.store(real, std::memory_order_relaxed);
+		_anchorGame.store(game, std::memory_order_relaxed);
+		_scale.store(scale, std::memory_order_relaxed);
+		_seq.store(seq + 2, std::memory_order_release);
+	}
+
+private:
+	static constexpr double MAX_SCALE = 4.0;
+	static constexpr double MAX_EXTRAPOLATION = 0.1;  // don't let game time run on while the game is paused; longer frames catch up in update().
+
+	static double gameAt(double a_real)
+	{
+		double anchorReal, anchorGame, scale;
+		while (true) {
+			auto seq = _seq.load(std::memory_order_acquire);
+			if (seq & 1) {
+				continue;
+			}
+			anchorReal = _anchorReal.load(std::memory_order_relaxed);
+			anchorGame = _anchorGame.load(std::memory_order_relaxed);
+			scale = _scale.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (_seq.load(std::memory_order_relaxed) == seq) {
+				break;
+			}
+		}
+		return anchorGame + std::clamp(a_real - anchorReal, 0.0, MAX_EXTRAPOLATION) * scale;
+	}
+
+	static inline std::atomic<std::uint32_t> _seq{ 0 };
+	static inline std::atomic<double>        _anchorReal{ 0.0 };
+	static inline std::atomic<double>        _anchorGame{ 0.0 };
+	static inline std::atomic<double>        _scale{ 1.0 };
+	static inline double                     _lastFrameReal{ 0.0 };
+};
@@ -0,0 +1,170 @@
+#include "ScoreTables.h"
+
+namespace
+{
+	std::string toLower(std::string_view a_str)
+	{
+		std::string lower(a_str);
+		std::ranges::transform(lower, lower.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return lower;
+	}
+}
+
+void ScoreTables::build(const Milf& a_settings)
+{
+	buildRaceScores(a_settings);
+	buildWeaponClasses(a_settings);
+}
+
+void ScoreTables::buildRaceScores(const Milf& a_settings)
+{
+	const auto& scores = a_settings.scores;
+	// Vanilla playable races and their vampire variants.
+	const std::pair<RE::FormID, double> vanillaRaces[] = {
+		{ 0x13743, scores.altmerScore }, { 0x88840, scores.altmerScore },
+		{ 0x13740, scores.argonianScore }, { 0x8883A, scores.argonianScore },
+		{ 0x13749, scores.bosmerScore }, { 0x88884, scores.bosmerScore },
+		{ 0x13741, scores.bretonScore }, { 0x8883C, scores.bretonScore },
+		{ 0x13742, scores.dunmerScore }, { 0x8883D, scores.dunmerScore },
+		{ 0x13744, scores.imperialScore }, { 0x88844, scores.imperialScore },
+		{ 0x13745, scores.khajiitScore }, { 0x88845, scores.khajiitScore },
+		{ 0x13746, scores.nordScore }, { 0x88794, scores.nordScore },
+		{ 0x13747, scores.orcScore }, { 0xA82B9, scores.orcScore },
+		{ 0x13748, scores.redguardScore }, { 0x88846, scores.redguardScore },
+	};
+
+	std::unordered_map<std::string, double> editorIDScores;
+	for (const auto& [editorID, score] : a_settings.races.editorIDScores) {
+		editorIDScores.emplace(toLower(editorID), score);
+	}
+
+	// Entries are pushed by priority, FormTable keeps the first one per race:
+	// EditorID mappings, then vanilla races, then keyword mappings.
+	std::vector<std::pair<RE::FormID, double>> entries;
+	auto& races = RE::TESDataHandler::GetSingleton()->GetFormArray<RE::TESRace>();
+	for (auto race : races) {
+		if (!race) {
+			continue;
+		}
+		if (auto editorID = race->GetFormEditorID(); editorID && *editorID) {
+			if (auto it = editorIDScores.find(toLower(editorID)); it != editorIDScores.end()) {
+				entries.emplace_back(race->GetFormID(), it->second);
+			}
+		}
+	}
+	entries.insert(entries.end(), std::begin(vanillaRaces), std::end(vanillaRaces));
+	if (!a_settings.races.keywordScores.empty()) {
+		for (auto race : races) {
+			if (!race) {
+				continue;
+			}
+			for (const auto& [keyword, score] : a_settings.races.keywordScores) {
+				if (race->HasKeywordString(keyword)) {
+					entries.emplace_back(race->GetFormID(), score);
+					break;
+				}
+			}
+		}
+	}
+
+	_raceScores.build(std::move(entries));
+	logger::info("Built race score table: {} of {} races scored.", _raceScores.size(), races.size());
+}
+
+WeaponClass ScoreTables::classifyWeapon(const RE::TESObjectWEAP* a_weapon, const WeaponScores& a_scores)
+{
+	WeaponClass weaponClass;
+
+	switch (a_weapon->GetWeaponType()) {
+	case RE::WEAPON_TYPE::kOneHandSword:
+		weaponClass.score = a_scores.oneHandSword;
+		weaponClass.rightHandBiped = RE::BIPED_OBJECT::kOneHandSword;
+		weaponClass.leftHandBiped = RE::BIPED_OBJECT::kShield;
+		break;
+	case RE::WEAPON_TYPE::kOneHandAxe:
+		weaponClass.score = a_scores.oneHandAxe;
+		weaponClass.rightHandBiped = RE::BIPED_OBJECT::kOneHandAxe;
+		weaponClass.leftHandBiped = RE::BIPED_OBJECT::kShield;
+		break;
+	case RE::WEAPON_TYPE::kOneHandMace:
+		weaponClass.score = a_scores.oneHandMace;
+		weaponClass.rightHandBiped = RE::BIPED_OBJECT::kOneHandMace;
+		weaponClass.leftHandBiped = RE::BIPED_OBJECT::kShield;
+		break;
+	case RE::WEAPON_TYPE::kOneHandDagger:
+		weaponClass.score = a_scores.oneHandDagger;
+		weaponClass.rightHandBiped = RE::BIPED_OBJECT::kOneHandDagger;
+		weaponClass.leftHandBiped = RE::BIPED_OBJECT::kShield;
+		break;
+	case RE::WEAPON_TYPE::kTwoHandSword:
+		weaponClass.score = a_scores.twoHandSword;
+		weaponClass.rightHandBiped = weaponClass.leftHandBiped = RE::BIPED_OBJECT::kTwoHandMelee;
+		break;
+	case RE::WEAPON_TYPE::kTwoHandAxe:
+		weaponClass.score = a_scores.twoHandAxe;
+		weaponClass.rightHandBiped = weaponClass.leftHandBiped = RE::BIPED_OBJECT::kTwoHandMelee;
+		break;
+	case RE::WEAPON_TYPE::kHandToHandMelee:
+		weaponClass.score = a_scores.handToHand;
+		weaponClass.rightHandBiped = weaponClass.leftHandBiped = RE::BIPED_OBJECT::kTwoHandMelee;
+		break;
+	default:
+		break;
+	}
+
+	// Vanilla warhammers are two-handed axes, Animated Armoury types reuse the vanilla ones; both are told apart by keyword.
+	const std::pair<const char*, float> keywordScores[] = {
+		{ "WeapTypeWarhammer", a_scores.twoHandWarhammer },
+		{ "WeapTypeKatana", a_scores.oneHandKatana },
+		{ "WeapTypeRapier", a_scores.oneHandRapier },
+		{ "WeapTypeClaw", a_scores.oneHandClaws },
+		{ "WeapTypeWhip", a_scores.oneHandWhip },
+		{ "WeapTypePike", a_scores.twoHandPike },
+		{ "WeapTypeHalberd", a_scores.twoHandHalberd },
+		{ "WeapTypeQtrStaff", a_scores.twoHandQuarterstaff },
+	};
+	for (const auto& [keyword, score] : keywordScores) {
+		if (a_weapon->HasKeywordString(keyword)) {
+			weaponClass.score = score;
+			break;
+		}
+	}
+
+	const auto skill = a_weapon->weaponData.skill.get();
+	if (skill == RE::ActorValue::kOneHanded || skill == RE::ActorValue::kTwoHanded) {
+		weaponClass.skill = skill;
+	}
+
+	return weaponClass;
+}
+
+void ScoreTables::buildWeaponClasses(const Milf& a_settings)
+{
+	const auto& scores = a_settings.scores;
+	_weaponScores.oneHandDagger = static_cast<float>(scores.oneHandDaggerScore);
+	_weaponScores.oneHandSword = static_cast<float>(scores.oneHandSwordScore);
+	_weaponScores.oneHandAxe = static_cast<float>(scores.oneHandAxeScore);
+	_weaponScores.oneHandMace = static_cast<float>(scores.oneHandMaceScore);
+	_weaponScores.oneHandKatana = static_cast<float>(scores.oneHandKatanaScore);
+	_weaponScores.oneHandRapier = static_cast<float>(scores.oneHandRapierScore);
+	_weaponScores.oneHandClaws = static_cast<float>(scores.oneHandClawsScore);
+	_weaponScores.oneHandWhip = static_cast<float>(scores.oneHandWhipScore);
+	_weaponScores.twoHandSword = static_cast<float>(scores.twoHandSwordScore);
+	_weaponScores.twoHandAxe = static_cast<float>(scores.twoHandAxeScore);
+	_weaponScores.twoHandWarhammer = static_cast<float>(scores.twoHandWarhammerScore);
+	_weaponScores.twoHandPike = static_cast<float>(scores.twoHandPikeScore);
+	_weaponScores.twoHandHalberd = static_cast<float>(scores.twoHandHalberdScore);
+	_weaponScores.twoHandQuarterstaff = static_cast<float>(scores.twoHandQuarterstaffScore);
+
+	std::vector<std::pair<RE::FormID, WeaponClass>> entries;
+	auto& weapons = RE::TESDataHandler::GetSingleton()->GetFormArray<RE::TESObjectWEAP>();
+	entries.reserve(weapons.size());
+	for (auto weapon : weapons) {
+		if (weapon) {
+			entries.emplace_back(weapon->GetFormID(), classifyWeapon(weapon, _weaponScores));
+		}
+	}
+
+	_weaponClasses.build(std::move(entries));
+	logger::info("Built weapon class table: {} weapons classified.", _weaponClasses.size());
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "EldenParry.h"
+
+/*Compact formID -> value index. Built once, then read-only: ids are kept sorted in their own
+array so a lookup is a binary search over a few cache lines.*/
+template <class T>
+class FormTable
+{
+public:
+	/*Replace the table's content. If a formID appears more than once, the first entry wins.*/
+	void build(std::vector<std::pair<RE::FormID, T>> a_entries)
+	{
+		std::ranges::stable_sort(a_entries, {}, &std::pair<RE::FormID, T>::first);
+		_ids.clear();
+		_values.clear();
+		_ids.reserve(a_entries.size());
+		_values.reserve(a_entries.size());
+		for (auto& [id, value] : a_entries) {
+			if (!_ids.empty() && _ids.back() == id) {
+				continue;
+			}
+			_ids.push_back(id);
+			_values.push_back(std::move(value));
+		}
+	}
+
+	const T* find(RE::FormID a_id) const
+	{
+		auto it = std::ranges::lower_bound(_ids, a_id);
+		if (it == _ids.end() || *it != a_id) {
+			return nullptr;
+		}
+		return std::addressof(_values[it - _ids.begin()]);
+	}
+
+	std::size_t size() const { return _ids.size(); }
+
+private:
+	std::vector<RE::FormID> _ids;
+	std::vector<T>          _values;
+};
+
+/*Everything the hot paths need to know about a weapon, resolved once per form.*/
+struct WeaponClass
+{
+	float            score{ 0.0f };                         // riposte score bonus.
+	RE::ActorValue   skill{ RE::ActorValue::kNone };        // skill added to the riposte score; kNone if none.
+	RE::BIPED_OBJECT rightHandBiped{ RE::BIPED_OBJECT::kNone };  // biped slot holding the weapon in the right hand.
+	RE::BIPED_OBJECT leftHandBiped{ RE::BIPED_OBJECT::kNone };   // biped slot holding the weapon in the left hand.
+};
+
+/*Score lookup tables built from the loaded forms at kDataLoaded.*/
+class ScoreTables
+{
+public:
+	static ScoreTables* GetSingleton()
+	{
+		static ScoreTables singleton;
+		return std::addressof(singleton);
+	}
+
+	void build(const Milf& a_settings);
+
+	/*Classification of the weapon. Weapons created after data load (e.g. player enchanted) are classified on the fly.*/
+	WeaponClass getWeaponClass(const RE::TESObjectWEAP* a_weapon) const
+	{
+		if (!a_weapon) {
+			return {};
+		}
+		if (auto weaponClass = _weaponClasses.find(a_weapon->GetFormID())) {
+			return *weaponClass;
+		}
+		return classifyWeapon(a_weapon, _weaponScores);
+	}
+
+	/*Bonus score for the race; 0 for races without an entry.*/
+	double getRaceScore(const RE::TESRace* a_race) const
+	{
+		if (!a_race) {
+			return 0.0;
+		}
+		auto score = _raceScores.find(a_race->GetFormID());
+		return score ? *score : 0.0;
+	}
+
+private:
+	/*Weapon score bonuses captured from the settings when the tables were built.*/
+	struct WeaponScores
+	{
+		float oneHandDagger{ 0.0f };
+		float oneHandSword{ 0.0f };
+		float oneHandAxe{ 0.0f };
+		float oneHandMace{ 0.0f };
+		float oneHandKatana{ 0.0f };
+		float oneHandRapier{ 0.0f };
+		float oneHandClaws{ 0.0f };
+		float oneHandWhip{ 0.0f };
+		float twoHandSword{ 0.0f };
+		float twoHandAxe{ 0.0f };
+		float twoHandWarhammer{ 0.0f };
+		float twoHandPike{ 0.0f };
+		float twoHandHalberd{ 0.0f };
+		float twoHandQuarterstaff{ 0.0f };
+		float handToHand{ -50.0f };
+	};
+
+	static WeaponClass classifyWeapon(const RE::TESObjectWEAP* a_weapon, const WeaponScores& a_scores);
+
+	void buildRaceScores(const Milf& a_settings);
+	void buildWeaponClasses(const Milf& a_settings);
+
+	FormTable<double>      _raceScores;
+	FormTable<WeaponClass> _weaponClasses;
+	WeaponScores           _weaponScores;
+};
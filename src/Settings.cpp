@@ -1,31 +1,100 @@
 #include "Settings.h"
+#include "ParryClock.h"
+#include "SettingsSnapshot.h"
+#include "TraceRecorder.h"
 
-void Settings::readSettings() {
+void Settings::readSettings(Config& a_config) {
 	logger::info("Reading settings...");
 	CSimpleIniA settings;
 	readSimpleIni(settings, settingsDir);
 
-	ReadBoolSetting(settings, "General", "bEnableWeaponParry", bEnableWeaponParry);
-	ReadBoolSetting(settings, "General", "bEnableShieldParry", bEnableShieldParry);
-	ReadBoolSetting(settings, "General", "bEnableNPCParry", bEnableNPCParry);
-	ReadBoolSetting(settings, "General", "bSuccessfulParryNoCost", bSuccessfulParryNoCost);
+	ReadBoolSetting(settings, "General", "bEnableWeaponParry", a_config.bEnableWeaponParry);
+	ReadBoolSetting(settings, "General", "bEnableShieldParry", a_config.bEnableShieldParry);
+	ReadBoolSetting(settings, "General", "bEnableNPCParry", a_config.bEnableNPCParry);
+	ReadBoolSetting(settings, "General", "bSuccessfulParryNoCost", a_config.bSuccessfulParryNoCost);
 
-	ReadFloatSetting(settings, "General", "fParryWindow_Start", fParryWindow_Start);
-	ReadFloatSetting(settings, "General", "fParryWindow_End", fParryWindow_End);
+	ReadFloatSetting(settings, "General", "fParryWindow_Start", a_config.fParryWindow_Start);
+	ReadFloatSetting(settings, "General", "fParryWindow_End", a_config.fParryWindow_End);
+	ReadBoolSetting(settings, "General", "bUseRealTimeParryWindow", a_config.bUseRealTimeParryWindow);
 
-	ReadBoolSetting(settings, "Effects", "bEnableSlowTimeEffect", bEnableSlowTimeEffect);
-	ReadBoolSetting(settings, "Effects", "bEnableScreenShakeEffect", bEnableScreenShakeEffect);
-	ReadBoolSetting(settings, "Effects", "bEnableParrySparkEffect", bEnableParrySparkEffect);
-	ReadBoolSetting(settings, "Effects", "bEnableParrySoundEffect", bEnableParrySoundEffect);
+	ReadBoolSetting(settings, "Effects", "bEnableSlowTimeEffect", a_config.bEnableSlowTimeEffect);
+	ReadBoolSetting(settings, "Effects", "bEnableScreenShakeEffect", a_config.bEnableScreenShakeEffect);
+	ReadBoolSetting(settings, "Effects", "bEnableParrySparkEffect", a_config.bEnableParrySparkEffect);
+	ReadBoolSetting(settings, "Effects", "bEnableParrySoundEffect", a_config.bEnableParrySoundEffect);
 
-	ReadBoolSetting(settings, "GuardBash", "bEnableWeaponGuardBash", bEnableWeaponGuardBash);
-	ReadBoolSetting(settings, "GuardBash", "bEnableShieldGuardBash", bEnableShieldGuardBash);
+	ReadBoolSetting(settings, "GuardBash", "bEnableWeaponGuardBash", a_config.bEnableWeaponGuardBash);
+	ReadBoolSetting(settings, "GuardBash", "bEnableShieldGuardBash", a_config.bEnableShieldGuardBash);
 
-	ReadBoolSetting(settings, "ProjectileParry", "bEnableArrowProjectileDeflection", bEnableArrowProjectileDeflection);
-	ReadBoolSetting(settings, "ProjectileParry", "bEnableMagicProjectileDeflection", bEnableMagicProjectileDeflection);
+	ReadBoolSetting(settings, "ProjectileParry", "bEnableArrowProjectileDeflection", a_config.bEnableArrowProjectileDeflection);
+	ReadBoolSetting(settings, "ProjectileParry", "bEnableMagicProjectileDeflection", a_config.bEnableMagicProjectileDeflection);
 
-	ReadFloatSetting(settings, "Experience", "fProjectileParryExp", fProjectileParryExp);
-	ReadFloatSetting(settings, "Experience", "fMeleeParryExp", fMeleeParryExp);
+	ReadFloatSetting(settings, "Experience", "fProjectileParryExp", a_config.fProjectileParryExp);
+	ReadFloatSetting(settings, "Experience", "fMeleeParryExp", a_config.fMeleeParryExp);
+
+	ReadBoolSetting(settings, "NPCParryAI", "bEnableNPCParryAI", a_config.bEnableNPCParryAI);
+	ReadFloatSetting(settings, "NPCParryAI", "fNPCParryAIChance", a_config.fNPCParryAIChance);
+	ReadFloatSetting(settings, "NPCParryAI", "fNPCParryAIRange", a_config.fNPCParryAIRange);
+	ReadFloatSetting(settings, "NPCParryAI", "fNPCParryAIReactionTime", a_config.fNPCParryAIReactionTime);
+	ReadFloatSetting(settings, "NPCParryAI", "fNPCParryAIBudget", a_config.fNPCParryAIBudget);
+
+	ReadBoolSetting(settings, "ModEvents", "bSendModEvents", a_config.bSendModEvents);
+
+	ReadBoolSetting(settings, "Debug", "bEnableLatencyStats", a_config.bEnableLatencyStats);
+	ReadFloatSetting(settings, "Debug", "fLatencyDumpInterval", a_config.fLatencyDumpInterval);
+	ReadBoolSetting(settings, "Debug", "bRunBenchmark", a_config.bRunBenchmark);
+	ReadBoolSetting(settings, "Debug", "bRecordTrace", a_config.bRecordTrace);
+	ReadIntSetting(settings, "Debug", "iTraceCapacity", a_config.iTraceCapacity);
+	ReadBoolSetting(settings, "Debug", "bHotReloadSettings", a_config.bHotReloadSettings);
 
 	logger::info("done");
-}
\ No newline at end of file
+}
+
+Settings::Config Settings::load()
+{
+	Config config;
+	readSettings(config);
+	auto milf = Milf::GetSingleton();
+	milf->Load();
+	config.useScoreSystem = milf->core.useScoreSystem;
+	config.scores = milf->scores;
+	return config;
+}
+
+void Settings::publish(const Config& a_config)
+{
+	std::error_code ec;
+	_settingsWriteTime = std::filesystem::last_write_time(settingsDir, ec);
+	_riposteWriteTime = std::filesystem::last_write_time(Milf::path, ec);
+
+	auto previous = _current.exchange(new Config(a_config), std::memory_order_acq_rel);
+	if (previous != std::addressof(_defaults)) {
+		_retired.push_back({ std::unique_ptr<const Config>(previous), ParryClock::realNow() });
+	}
+	if (auto recorder = TraceRecorder::GetSingleton(); recorder->enabled()) {
+		recorder->recordConfig(a_config);
+	}
+}
+
+void Settings::update()
+{
+	const double now = ParryClock::realNow();
+	std::erase_if(_retired, [now](const Retired& a_retired) { return now - a_retired.time > RETIRE_GRACE; });
+
+	if (!get().bHotReloadSettings || now < _nextWatch) {
+		return;
+	}
+	_nextWatch = now + WATCH_INTERVAL;
+
+	std::error_code ec;
+	auto settingsWriteTime = std::filesystem::last_write_time(settingsDir, ec);
+	auto riposteWriteTime = std::filesystem::last_write_time(Milf::path, ec);
+	if (settingsWriteTime == _settingsWriteTime && riposteWriteTime == _riposteWriteTime) {
+		return;
+	}
+	logger::info("Settings changed, reloading.");
+	auto config = load();
+	publish(config);
+	SettingsSnapshot::save(config);
+	// scores are cached per actor; drop them so the new weights apply.
+	EldenParry::GetSingleton()->invalidateAllScores();
+}
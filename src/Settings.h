@@ -1,6 +1,8 @@
 #pragma once
 
 #include <SimpleIni.h>
+
+#include "EldenParry.h"
 using std::string;
 
 static const char* settingsDir = "Data\\SKSE\\Plugins\\EldenParry.ini";
@@ -13,35 +15,129 @@ public:
 		static inline bool isPrecisionAPIObtained = false;
 		static inline bool isValhallaCombatAPIObtained = false;
 	};
-	static inline float fParryWindow_Start = 0.0f;
-	static inline float fParryWindow_End = 0.3f;
+	/*Immutable set of all settings of EldenParry.ini and EldenRiposteSystem.ini.
+	A new config is built and published whenever the inis are read, so readers never see a half-updated config.*/
+	struct Config
+	{
+		float fParryWindow_Start = 0.0f;
+		float fParryWindow_End = 0.3f;
+		bool bUseRealTimeParryWindow = false;
+
+		bool bEnableWeaponParry = true;
+		bool bEnableShieldParry = true;
+		bool bEnableNPCParry = true;
+		bool bSuccessfulParryNoCost = true;
+
+
+
+		bool bEnableSlowTimeEffect = false;
+		bool bEnableScreenShakeEffect = true;
+		bool bEnableParrySparkEffect = true;
+		bool bEnableParrySoundEffect = true;
+
+
+		bool bEnableArrowProjectileDeflection = true;
+		bool bEnableMagicProjectileDeflection = true;
+
+		bool bEnableShieldGuardBash = true;
+		bool bEnableWeaponGuardBash = true;
+
+		float fProjectileParryExp = 20.0f;
+		float fMeleeParryExp = 10.0f;
+		float fGuardBashExp = 10.0f;
 
-	static inline bool bEnableWeaponParry = true;
-	static inline bool bEnableShieldParry = true;
-	static inline bool bEnableNPCParry = true;
-	static inline bool bSuccessfulParryNoCost = true;
+		bool  bEnableNPCParryAI = false;  // let NPCs in combat decide to parry incoming swings; requires bEnableNPCParry.
+		float fNPCParryAIChance = 0.5f;   // chance to parry a swing that would stagger the attacker normally.
+		float fNPCParryAIRange = 300.0f;  // distance within which a swing is considered a threat.
+		float fNPCParryAIReactionTime = 0.15f;  // seconds from an attack's wind-up to the NPC's bash.
+		float fNPCParryAIBudget = 0.25f;  // milliseconds of evaluation per frame; NPCs not evaluated wait for the next frame.
 
+		bool bSendModEvents = false;  // Papyrus mod events; native plugins use the EldenParry API instead.
 
+		bool bEnableLatencyStats = false;
+		float fLatencyDumpInterval = 0.0f;  // seconds between latency dumps; 0 dumps on save only.
+		bool bRunBenchmark = false;
+		bool bRecordTrace = false;
+		uint32_t iTraceCapacity = 262144;  // records kept in the trace file, 64 bytes each.
+		bool bHotReloadSettings = false;  // watch the inis and apply changes while the game runs.
 
-	static inline bool bEnableSlowTimeEffect = false;
-	static inline bool bEnableScreenShakeEffect = true;
-	static inline bool bEnableParrySparkEffect = true;
-	static inline bool bEnableParrySoundEffect = true;
+		// from EldenRiposteSystem.ini.
+		bool         useScoreSystem = true;
+		Milf::Scores scores;
 
+		/*Visit every setting read from the ini, for the settings snapshot.*/
+		template <class Archive>
+		void serialize(Archive& a_ar)
+		{
+			a_ar(fParryWindow_Start);
+			a_ar(fParryWindow_End);
+			a_ar(bUseRealTimeParryWindow);
+			a_ar(bEnableWeaponParry);
+			a_ar(bEnableShieldParry);
+			a_ar(bEnableNPCParry);
+			a_ar(bSuccessfulParryNoCost);
+			a_ar(bEnableSlowTimeEffect);
+			a_ar(bEnableScreenShakeEffect);
+			a_ar(bEnableParrySparkEffect);
+			a_ar(bEnableParrySoundEffect);
+			a_ar(bEnableArrowProjectileDeflection);
+			a_ar(bEnableMagicProjectileDeflection);
+			a_ar(bEnableShieldGuardBash);
+			a_ar(bEnableWeaponGuardBash);
+			a_ar(fProjectileParryExp);
+			a_ar(fMeleeParryExp);
+			a_ar(fGuardBashExp);
+			a_ar(bEnableNPCParryAI);
+			a_ar(fNPCParryAIChance);
+			a_ar(fNPCParryAIRange);
+			a_ar(fNPCParryAIReactionTime);
+			a_ar(fNPCParryAIBudget);
+			a_ar(bSendModEvents);
+			a_ar(bEnableLatencyStats);
+			a_ar(fLatencyDumpInterval);
+			a_ar(bRunBenchmark);
+			a_ar(bRecordTrace);
+			a_ar(iTraceCapacity);
+			a_ar(bHotReloadSettings);
+			// useScoreSystem and scores are copies of Milf's, which are serialized with Milf.
+		}
+	};
 
-	static inline bool bEnableArrowProjectileDeflection = true;
-	static inline bool bEnableMagicProjectileDeflection = true;
+	/*The current config. Lock-free, any thread.
+	Don't hold on to the reference beyond the current hook call or frame: replaced configs are freed after a grace period.*/
+	static const Config& get()
+	{
+		return *_current.load(std::memory_order_acquire);
+	}
 
-	static inline bool bEnableShieldGuardBash = true;
-	static inline bool bEnableWeaponGuardBash = true;
+	/*Read both inis into a new config.*/
+	static Config load();
 
-	static inline float fProjectileParryExp = 20.0f;
-	static inline float fMeleeParryExp = 10.0f;
-	static inline float fGuardBashExp = 10.0f;
+	/*Make a_config the current config. Main thread only.*/
+	static void publish(const Config& a_config);
 
-	static void readSettings();
+	/*Reload the inis if hot reload is enabled and they changed, and free configs retired long enough ago. Main thread, once per frame.*/
+	static void update();
 
 	private:
+	static constexpr double RETIRE_GRACE = 5.0;  // seconds a replaced config stays alive for readers still holding it.
+	static constexpr double WATCH_INTERVAL = 1.0;
+
+	struct Retired
+	{
+		std::unique_ptr<const Config> config;
+		double                        time;
+	};
+
+	static void readSettings(Config& a_config);
+
+	static inline const Config                    _defaults{};
+	static inline std::atomic<const Config*>      _current{ &_defaults };
+	static inline std::vector<Retired>            _retired;
+	static inline double                          _nextWatch{ 0.0 };
+	static inline std::filesystem::file_time_type _settingsWriteTime{};
+	static inline std::filesystem::file_time_type _riposteWriteTime{};
+
 	static bool readSimpleIni(CSimpleIniA& a_ini, const char* a_iniAddress)
 	{
 		if (std::filesystem::exists(a_iniAddress)) {
@@ -0,0 +1,228 @@
+#include "SettingsSnapshot.h"
+#include "EldenParry.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	constexpr std::uint32_t MAGIC = 0x53535045;  // "EPSS" on disk.
+	constexpr std::uint32_t FORMAT_VERSION = 4;
+
+	/*Identity of a source ini.*/
+	struct SourceStamp
+	{
+		std::uint64_t size{ 0 };
+		std::int64_t  mtime{ 0 };
+		std::uint64_t hash{ 0 };
+
+		bool operator==(const SourceStamp&) const = default;
+	};
+
+	struct Header
+	{
+		std::uint32_t magic{ MAGIC };
+		std::uint32_t formatVersion{ FORMAT_VERSION };
+		std::uint32_t pluginVersion{ Plugin::VERSION.pack() };
+		std::uint32_t payloadSize{ 0 };
+		SourceStamp   settingsIni;
+		SourceStamp   riposteIni;
+	};
+
+	std::uint64_t fnv1a(std::string_view a_data)
+	{
+		std::uint64_t hash = 0xcbf29ce484222325ull;
+		for (auto c : a_data) {
+			hash ^= static_cast<std::uint8_t>(c);
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	/*Read a whole file with a single read. Empty if it can't be read.*/
+	std::string readFile(const std::filesystem::path& a_path)
+	{
+		std::string content;
+		std::ifstream file(a_path, std::ios::binary | std::ios::ate);
+		if (!file) {
+			return content;
+		}
+		content.resize(static_cast<std::size_t>(file.tellg()));
+		file.seekg(0);
+		if (!file.read(content.data(), static_cast<std::streamsize>(content.size()))) {
+			content.clear();
+		}
+		return content;
+	}
+
+	SourceStamp stampOf(const std::filesystem::path& a_path)
+	{
+		SourceStamp     stamp;
+		std::error_code ec;
+		auto            mtime = std::filesystem::last_write_time(a_path, ec);
+		if (ec) {
+			stamp.size = UINT64_MAX;  // missing: only matches a snapshot taken while it was missing too.
+			return stamp;
+		}
+		stamp.mtime = mtime.time_since_epoch().count();
+		auto content = readFile(a_path);
+		stamp.size = content.size();
+		stamp.hash = fnv1a(content);
+		return stamp;
+	}
+
+	std::optional<std::filesystem::path> snapshotPath()
+	{
+		auto path = logger::log_directory();
+		if (path) {
+			*path /= "EldenParry.settings.bin"sv;
+		}
+		return path;
+	}
+
+	class Writer
+	{
+	public:
+		template <class T>
+		void operator()(T& a_value)
+		{
+			if constexpr (std::is_trivially_copyable_v<T>) {
+				auto bytes = reinterpret_cast<const char*>(std::addressof(a_value));
+				buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+			} else if constexpr (std::is_same_v<T, std::string>) {
+				auto size = static_cast<std::uint32_t>(a_value.size());
+				(*this)(size);
+				buffer.insert(buffer.end(), a_value.begin(), a_value.end());
+			} else {  // std::vector<std::pair<std::string, double>>
+				auto size = static_cast<std::uint32_t>(a_value.size());
+				(*this)(size);
+				for (auto& [name, score] : a_value) {
+					(*this)(name);
+					(*this)(score);
+				}
+			}
+		}
+
+		std::string buffer;
+	};
+
+	class Reader
+	{
+	public:
+		explicit Reader(std::string_view a_data) :
+			_data(a_data)
+		{}
+
+		template <class T>
+		void operator()(T& a_value)
+		{
+			if constexpr (std::is_trivially_copyable_v<T>) {
+				if (take(sizeof(T))) {
+					std::memcpy(std::addressof(a_value), _data.data() + _pos - sizeof(T), sizeof(T));
+				}
+			} else if constexpr (std::is_same_v<T, std::string>) {
+				std::uint32_t size = 0;
+				(*this)(size);
+				if (take(size)) {
+					a_value.assign(_data.data() + _pos - size, size);
+				}
+			} else {
+				std::uint32_t size = 0;
+				(*this)(size);
+				a_value.clear();
+				for (std::uint32_t i = 0; i < size && ok; ++i) {
+					auto& [name, score] = a_value.emplace_back();
+					(*this)(name);
+					(*this)(score);
+				}
+			}
+		}
+
+		bool done() const { return ok && _pos == _data.size(); }
+
+		bool ok{ true };
+
+	private:
+		bool take(std::size_t a_size)
+		{
+			if (!ok || _data.size() - _pos < a_size) {
+				ok = false;
+				return false;
+			}
+			_pos += a_size;
+			return true;
+		}
+
+		std::string_view _data;
+		std::size_t      _pos{ 0 };
+	};
+}
+
+bool SettingsSnapshot::load(Settings::Config& a_config)
+{
+	auto path = snapshotPath();
+	if (!path) {
+		return false;
+	}
+	auto data = readFile(*path);
+	if (data.size() < sizeof(Header)) {
+		return false;
+	}
+	Header header;
+	std::memcpy(&header, data.data(), sizeof(Header));
+	if (header.magic != MAGIC || header.formatVersion != FORMAT_VERSION || header.pluginVersion != Plugin::VERSION.pack() ||
+		header.payloadSize != data.size() - sizeof(Header)) {
+		return false;
+	}
+	if (header.settingsIni != stampOf(settingsDir) || header.riposteIni != stampOf(Milf::path)) {
+		logger::info("Settings changed since the last launch, reading the ini files.");
+		return false;
+	}
+
+	// a corrupt payload must not leave settings half-restored.
+	Reader reader(std::string_view(data).substr(sizeof(Header)));
+	Writer backup;
+	Milf::GetSingleton()->serialize(backup);
+	Settings::Config config;
+	config.serialize(reader);
+	Milf::GetSingleton()->serialize(reader);
+	if (!reader.done()) {
+		Reader restore(backup.buffer);
+		Milf::GetSingleton()->serialize(restore);
+		logger::warn("Settings snapshot is corrupt, reading the ini files.");
+		return false;
+	}
+	auto milf = Milf::GetSingleton();
+	config.useScoreSystem = milf->core.useScoreSystem;
+	config.scores = milf->scores;
+	a_config = config;
+	logger::info("Settings restored from snapshot.");
+	return true;
+}
+
+void SettingsSnapshot::save(const Settings::Config& a_config)
+{
+	auto path = snapshotPath();
+	if (!path) {
+		return;
+	}
+	Writer payload;
+	auto   config = a_config;
+	config.serialize(payload);
+	Milf::GetSingleton()->serialize(payload);
+
+	Header header;
+	header.payloadSize = static_cast<std::uint32_t>(payload.buffer.size());
+	header.settingsIni = stampOf(settingsDir);
+	header.riposteIni = stampOf(Milf::path);
+
+	std::string data(reinterpret_cast<const char*>(&header), sizeof(Header));
+	data += payload.buffer;
+	if (readFile(*path) == data) {
+		return;
+	}
+	std::ofstream file(*path, std::ios::binary | std::ios::trunc);
+	if (!file.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+		logger::warn("Failed to write settings snapshot {}", path->string());
+	}
+}
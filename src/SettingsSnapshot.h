@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Settings.h"
+
+/*Binary snapshot of the settings config and Milf, so startup skips parsing both ini files.
+The snapshot records the size, modification time and FNV-1a hash of each ini it was built from and is
+only used if all of them still match; otherwise the inis are parsed and the snapshot rebuilt.*/
+class SettingsSnapshot
+{
+public:
+	/*Restore the config and Milf from the snapshot.
+	@return false if there is no snapshot or it is stale; a_config and Milf are left untouched.*/
+	static bool load(Settings::Config& a_config);
+
+	/*Write a_config and Milf to the snapshot. Call after the inis have been read.*/
+	static void save(const Settings::Config& a_config);
+};
@@ -0,0 +1,76 @@
+#include "TraceRecorder.h"
+#include "CoreAdapter.h"
+#include "ParryClock.h"
+#include "Settings.h"
+
+void TraceRecorder::start(float a_blockAngle)
+{
+	const auto& settings = Settings::get();
+	if (!settings.bRecordTrace || _thread.joinable()) {
+		return;
+	}
+	auto path = logger::log_directory();
+	if (!path) {
+		return;
+	}
+	*path /= "EldenParry.trace"sv;
+
+	ParryCore::TraceHeader header;
+	header.capacity = (std::max)(settings.iTraceCapacity, 1u);
+	header.window = CoreAdapter::parryWindow(settings);
+	header.blockAngle = a_blockAngle;
+	header.flags = settings.bSuccessfulParryNoCost ? ParryCore::TraceHeader::kSettleCost : ParryCore::TraceHeader::kNone;
+	if (!_writer.open(path->string(), header)) {
+		logger::error("Failed to open trace file {}", path->string());
+		return;
+	}
+	logger::info("Recording combat trace to {}", path->string());
+
+	_blockAngle = a_blockAngle;
+	_enabled.store(true, std::memory_order_relaxed);
+	_thread = std::jthread([this](std::stop_token a_stop) {
+		while (!a_stop.stop_requested()) {
+			std::this_thread::sleep_for(100ms);
+			drain();
+		}
+		drain();
+	});
+}
+
+void TraceRecorder::drain()
+{
+	std::array<ParryCore::TraceRecord, 256> batch;
+	std::size_t                             count = 0;
+	bool                                    wrote = false;
+	while (_queue.pop(batch[count])) {
+		if (++count == batch.size()) {
+			_writer.write(batch.data(), count);
+			count = 0;
+			wrote = true;
+		}
+	}
+	if (count) {
+		_writer.write(batch.data(), count);
+		wrote = true;
+	}
+	if (wrote) {
+		_writer.flush();
+	}
+	auto dropped = _dropped.load(std::memory_order_relaxed);
+	if (dropped != _reportedDropped) {
+		logger::warn("Trace queue full: {} records dropped.", dropped - _reportedDropped);
+		_reportedDropped = dropped;
+	}
+}
+
+void TraceRecorder::recordConfig(const Settings::Config& a_config)
+{
+	ParryCore::TraceRecord record;
+	record.type = ParryCore::TraceRecord::Type::kConfig;
+	record.time = ParryClock::now(a_config.bUseRealTimeParryWindow);
+	record.value = _blockAngle;
+	const auto window = CoreAdapter::parryWindow(a_config);
+	record.target = { window.start, window.end, 0.0f };
+	record.flags = a_config.bSuccessfulParryNoCost ? ParryCore::TraceRecord::kSettleCost : ParryCore::TraceRecord::kNone;
+	this->record(record);
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <thread>
+
+#include "ParryCore/MPSCQueue.h"
+#include "ParryCore/Trace.h"
+#include "Settings.h"
+
+/*Opt-in recorder of every input EldenParry decides on, for offline replay with core/tools/ParryReplay.
+Hooks push records to a preallocated ring without blocking; a background thread appends them to
+EldenParry.trace in the log directory, a ring file holding the last iTraceCapacity records.*/
+class TraceRecorder
+{
+public:
+	static TraceRecorder* GetSingleton()
+	{
+		static TraceRecorder singleton;
+		return std::addressof(singleton);
+	}
+
+	/*Start recording if enabled in the settings.
+	@param a_blockAngle: block angle parries are decided with.*/
+	void start(float a_blockAngle);
+
+	bool enabled() const { return _enabled.load(std::memory_order_relaxed); }
+
+	/*Record settings published while recording, so the trace replays with the settings each decision was made with.*/
+	void recordConfig(const Settings::Config& a_config);
+
+	/*Any thread. Records that change an actor's state must be recorded while the state is written (from the
+	ActorStateTable::modify callback), so that decisions which read the new state are recorded after them.
+	When the queue is full the record is dropped, and the next one that fits is preceded by a kGap record.*/
+	void record(const ParryCore::TraceRecord& a_record)
+	{
+		if (_gap.load(std::memory_order_relaxed) && _gap.exchange(false, std::memory_order_relaxed)) {
+			ParryCore::TraceRecord gap;
+			gap.type = ParryCore::TraceRecord::Type::kGap;
+			gap.time = a_record.time;
+			if (!_queue.push(gap)) {
+				drop();
+				return;
+			}
+		}
+		if (!_queue.push(a_record)) {
+			drop();
+		}
+	}
+
+	static ParryCore::TraceRecord makeRecord(ParryCore::TraceRecord::Type a_type, double a_time, RE::TESObjectREFR* a_actor, RE::TESObjectREFR* a_other = nullptr)
+	{
+		ParryCore::TraceRecord record;
+		record.type = a_type;
+		record.time = a_time;
+		record.actor = a_actor->GetHandle().native_handle();
+		record.other = a_other ? a_other->GetHandle().native_handle() : 0;
+		return record;
+	}
+
+private:
+	TraceRecorder() = default;
+
+	void drain();
+
+	void drop()
+	{
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+		_gap.store(true, std::memory_order_relaxed);
+	}
+
+	std::atomic<bool>                       _enabled{ false };
+	float                                   _blockAngle{ 0.0f };
+	MPSCQueue<ParryCore::TraceRecord, 4096> _queue;
+	std::atomic<std::uint64_t>              _dropped{ 0 };
+	std::atomic<bool>                       _gap{ false };
+	std::uint64_t                           _reportedDropped{ 0 };
+	ParryCore::TraceWriter                  _writer;
+	std::jthread                            _thread;
+};
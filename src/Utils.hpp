@@ -1,6 +1,13 @@
 #pragma once
+#include "CoreAdapter.h"
+#include "Hitstop.h"
+#include "ParryClock.h"
+#include "ScoreTables.h"
+#include "TraceRecorder.h"
 class Utils
 {
+	friend class ParryBenchmark;
+
 private:
 #define PI 3.1415926535897932384626f
 
@@ -52,11 +59,6 @@ private:
 	static inline const RE::BSFixedString recoilLargeStart = "recoilLargeStart";
 	static inline const RE::BSFixedString recoilStart = "recoilStart";
 
-	static inline bool ApproximatelyEqual(float A, float B)
-	{
-		return ((A - B) < FLT_EPSILON) && ((B - A) < FLT_EPSILON);
-	}
-
 	static inline void SetRotationMatrix(RE::NiMatrix3& a_matrix, float sacb, float cacb, float sb)
 	{
 		float cb = std::sqrtf(1 - sb * sb);
@@ -75,84 +77,10 @@ private:
 
 	static bool PredictAimProjectile(RE::NiPoint3 a_projectilePos, RE::NiPoint3 a_targetPosition, RE::NiPoint3 a_targetVelocity, float a_gravity, RE::NiPoint3& a_projectileVelocity)
 	{
-		// http://ringofblades.com/Blades/Code/PredictiveAim.cs
-
-		float projectileSpeedSquared = a_projectileVelocity.SqrLength();
-		float projectileSpeed = std::sqrtf(projectileSpeedSquared);
-
-		if (projectileSpeed <= 0.f || a_projectilePos == a_targetPosition) {
-			return false;
-		}
-
-		float targetSpeedSquared = a_targetVelocity.SqrLength();
-		float targetSpeed = std::sqrtf(targetSpeedSquared);
-		RE::NiPoint3 targetToProjectile = a_projectilePos - a_targetPosition;
-		float distanceSquared = targetToProjectile.SqrLength();
-		float distance = std::sqrtf(distanceSquared);
-		RE::NiPoint3 direction = targetToProjectile;
-		direction.Unitize();
-		RE::NiPoint3 targetVelocityDirection = a_targetVelocity;
-		targetVelocityDirection.Unitize();
-
-		float cosTheta = (targetSpeedSquared > 0) ? direction.Dot(targetVelocityDirection) : 1.0f;
-
-		bool bValidSolutionFound = true;
-		float t;
-
-		if (ApproximatelyEqual(projectileSpeedSquared, targetSpeedSquared)) {
-			// We want to avoid div/0 that can result from target and projectile traveling at the same speed
-			//We know that cos(theta) of zero or less means there is no solution, since that would mean B goes backwards or leads to div/0 (infinity)
-			if (cosTheta > 0) {
-				t = 0.5f * distance / (targetSpeed * cosTheta);
-			} else {
-				bValidSolutionFound = false;
-				t = 1;
-			}
-		} else {
-			float a = projectileSpeedSquared - targetSpeedSquared;
-			float b = 2.0f * distance * targetSpeed * cosTheta;
-			float c = -distanceSquared;
-			float discriminant = b * b - 4.0f * a * c;
-
-			if (discriminant < 0) {
-				// NaN
-				bValidSolutionFound = false;
-				t = 1;
-			} else {
-				// a will never be zero
-				float uglyNumber = sqrtf(discriminant);
-				float t0 = 0.5f * (-b + uglyNumber) / a;
-				float t1 = 0.5f * (-b - uglyNumber) / a;
-
-				// Assign the lowest positive time to t to aim at the earliest hit
-				t = min(t0, t1);
-				if (t < FLT_EPSILON) {
-					t = max(t0, t1);
-				}
-
-				if (t < FLT_EPSILON) {
-					// Time can't flow backwards when it comes to aiming.
-					// No real solution was found, take a wild shot at the target's future location
-					bValidSolutionFound = false;
-					t = 1;
-				}
-			}
-		}
-
-		a_projectileVelocity = a_targetVelocity + (-targetToProjectile / t);
-
-		if (!bValidSolutionFound) {
-			a_projectileVelocity.Unitize();
-			a_projectileVelocity *= projectileSpeed;
-		}
-
-		if (!ApproximatelyEqual(a_gravity, 0.f)) {
-			float netFallDistance = (a_projectileVelocity * t).z;
-			float gravityCompensationSpeed = (netFallDistance + 0.5f * a_gravity * t * t) / t;
-			a_projectileVelocity.z = gravityCompensationSpeed;
-		}
-
-		return bValidSolutionFound;
+		auto velocity = CoreAdapter::toVec3(a_projectileVelocity);
+		bool found = ParryCore::predictAim(CoreAdapter::toVec3(a_projectilePos), CoreAdapter::toVec3(a_targetPosition), CoreAdapter::toVec3(a_targetVelocity), a_gravity, velocity);
+		a_projectileVelocity = CoreAdapter::toNiPoint3(velocity);
+		return found;
 	}
 
 
@@ -161,20 +89,34 @@ public:
 
 	static void triggerStagger(RE::Actor* a_defender, RE::Actor* a_aggressor)
 	{
-		double a_reprisal = (EldenParry::GetSingleton()->AttackerBeatsParry(a_aggressor, a_defender));
-		
-		if (a_reprisal >= 30.0) {
+		const auto& settings = Settings::get();
+		auto        eldenParry = EldenParry::GetSingleton();
+		double      aggressorScore = eldenParry->GetScore(a_aggressor, settings.scores);
+		double      defenderScore = eldenParry->GetScore(a_defender, settings.scores);
+		double      a_reprisal = aggressorScore - defenderScore;  // same as AttackerBeatsParry, keeping the scores for the trace.
+
+		auto tier = ParryCore::staggerTier(a_reprisal);
+		if (auto recorder = TraceRecorder::GetSingleton(); recorder->enabled()) {
+			auto record = TraceRecorder::makeRecord(ParryCore::TraceRecord::Type::kStagger, ParryClock::now(settings.bUseRealTimeParryWindow), a_defender, a_aggressor);
+			record.target = { static_cast<float>(aggressorScore), static_cast<float>(defenderScore), 0.0f };
+			record.value = static_cast<float>(a_reprisal);
+			record.tier = tier;
+			recorder->record(record);
+		}
+
+		switch (tier) {
+		case ParryCore::StaggerTier::kDefenderLarge:
 			a_defender->NotifyAnimationGraph(recoilLargeStart);
-			return;
-		} else if (a_reprisal >= 20.0 && a_reprisal < 30.0) {
+			break;
+		case ParryCore::StaggerTier::kDefender:
 			a_defender->NotifyAnimationGraph(recoilStart);
-			return;
-		} else if (a_reprisal >= 10.0 && a_reprisal < 20.0) {
+			break;
+		case ParryCore::StaggerTier::kAttacker:
 			a_aggressor->NotifyAnimationGraph(recoilStart);
-			return;
-		} else if (a_reprisal < 10.0) {
+			break;
+		case ParryCore::StaggerTier::kAttackerLarge:
 			a_aggressor->NotifyAnimationGraph(recoilLargeStart);
-			return;
+			break;
 		}
 	};
 
@@ -319,20 +261,12 @@ public:
 		return func(This, a_percentage, a_unk);
 	}
 
-	/*Slow down game time for a set period.
+	/*Slow down game time for a set period. Applied by the hitstop engine on the next frame.
 	@param a_duration: duration of the slow time.
 	@param a_percentage: relative time speed to normal time(1).*/
 	static void slowTime(float a_duration, float a_percentage)
 	{
-		int duration_milisec = static_cast<int>(a_duration * 1000);
-		BSTimer_SetGlobalTimeMultiplier(BSTimer_GetSingleton(), a_percentage);
-		/*Reset time here*/
-		auto resetSlowTime = [](int a_duration) {
-			std::this_thread::sleep_for(std::chrono::milliseconds(a_duration));
-			BSTimer_SetGlobalTimeMultiplier(BSTimer_GetSingleton(), 1);
-		};
-		std::jthread resetThread(resetSlowTime, duration_milisec);
-		resetThread.detach();
+		Hitstop::GetSingleton()->request(a_duration, a_percentage);
 	}
 };
 
@@ -345,28 +279,40 @@ private:
 		if (!parryEquipment)
 			return RE::BIPED_OBJECT::kNone;
 
-		if (parryEquipment->As<RE::TESObjectWEAP>()) {
-			switch (parryEquipment->As<RE::TESObjectWEAP>()->GetWeaponType()) {
-			case RE::WEAPON_TYPE::kOneHandSword:
-				return rightHand ? RE::BIPED_OBJECT::kOneHandSword : RE::BIPED_OBJECT::kShield;
-			case RE::WEAPON_TYPE::kOneHandAxe:
-				return rightHand ? RE::BIPED_OBJECT::kOneHandAxe : RE::BIPED_OBJECT::kShield;
-			case RE::WEAPON_TYPE::kOneHandMace:
-				return rightHand ? RE::BIPED_OBJECT::kOneHandMace : RE::BIPED_OBJECT::kShield;
-			case RE::WEAPON_TYPE::kOneHandDagger:
-				return rightHand ? RE::BIPED_OBJECT::kOneHandDagger : RE::BIPED_OBJECT::kShield;
-			case RE::WEAPON_TYPE::kTwoHandAxe:
-			case RE::WEAPON_TYPE::kTwoHandSword:
-			case RE::WEAPON_TYPE::kHandToHandMelee:
-				return RE::BIPED_OBJECT::kTwoHandMelee;
-			}
+		if (auto weapon = parryEquipment->As<RE::TESObjectWEAP>()) {
+			const auto weaponClass = ScoreTables::GetSingleton()->getWeaponClass(weapon);
+			return rightHand ? weaponClass.rightHandBiped : weaponClass.leftHandBiped;
 		} else if (parryEquipment->IsArmor())
 			return RE::BIPED_OBJECT::kShield;
 
 		return RE::BIPED_OBJECT::kNone;
 	}
 
+	static constexpr std::array sparkModels{
+		"EldenParry\\impactShieldRoot.nif",
+		"EldenParry\\impactWeaponRoot.nif",
+		"ValhallaCombat\\impactShieldRoot.nif",
+		"ValhallaCombat\\impactWeaponRoot.nif",
+	};
+
+	/*Models held here stay in the model cache for the whole session.*/
+	static inline std::array<RE::NiPointer<RE::NiNode>, sparkModels.size()> pinnedSparkModels;
+
 public:
+	/*Load the spark models and keep them loaded, so the first parry of a session doesn't hitch on a model load.*/
+	static void preloadSparkModels()
+	{
+		RE::BSModelDB::DBTraits::ArgsType args{};
+		for (std::size_t i = 0; i < sparkModels.size(); ++i) {
+			if (pinnedSparkModels[i]) {
+				continue;
+			}
+			if (RE::BSModelDB::Demand(sparkModels[i], pinnedSparkModels[i], args) == RE::BSResource::ErrorCode::kNone && pinnedSparkModels[i]) {
+				logger::info("Preloaded {}", sparkModels[i]);
+			}
+		}
+	}
+
 	static RE::BSTempEffectParticle* TESObjectCELL_PlaceParticleEffect(RE::TESObjectCELL* a_cell, float a_lifetime, const char* a_modelName, const RE::NiMatrix3& a_normal, const RE::NiPoint3& a_pos, float a_scale, std::uint32_t a_flags, RE::NiAVObject* a_target)
 	{
 		using func_t = decltype(&TESObjectCELL_PlaceParticleEffect);
@@ -396,21 +342,8 @@ public:
 		if (!defenderNode || !defenderNode.get()) {
 			return;
 		}
-		const char* modelName;
-		if (BipeObjIndex == RE::BIPED_OBJECT::kShield && defenderLeftEquipped && defenderLeftEquipped->IsArmor()) {
-			if (Settings::facts::isValhallaCombatAPIObtained) {
-				modelName = "ValhallaCombat\\impactShieldRoot.nif";
-			} else {
-				modelName = "EldenParry\\impactShieldRoot.nif";
-			}
-			
-		} else {
-			if (Settings::facts::isValhallaCombatAPIObtained) {
-				modelName = "ValhallaCombat\\impactWeaponRoot.nif";
-			} else {
-				modelName = "EldenParry\\impactWeaponRoot.nif";
-			}
-		}
+		const bool  shield = BipeObjIndex == RE::BIPED_OBJECT::kShield && defenderLeftEquipped && defenderLeftEquipped->IsArmor();
+		const char* modelName = sparkModels[(Settings::facts::isValhallaCombatAPIObtained ? 2 : 0) + (shield ? 0 : 1)];
 		//DEBUG("Get Weapon Spark Position!");
 		TESObjectCELL_PlaceParticleEffect(a_actor->GetParentCell(), 0.0f, modelName, defenderNode->world.rotate, defenderNode->worldBound.center, 1.0f, 4U, defenderNode.get());
 	}
@@ -1,6 +1,13 @@
 #include "Hooks.h"
 #include "EldenParry.h"
 #include "AnimEventHandler.h"
+#include "ActorEventHandler.h"
+#include "HotLog.h"
+#include "LatencyStats.h"
+#include "NPCParryAI.h"
+#include "ParryBenchmark.h"
+#include "ScoreTables.h"
+#include "SettingsSnapshot.h"
 
 #include "Utils.hpp"
 
@@ -16,18 +23,33 @@ void MessageHandler(SKSE::MessagingInterface::Message* a_msg)
 		break;
 	case SKSE::MessagingInterface::kDataLoaded:  // All ESM/ESL/ESP plugins have loaded, main menu is now active.
 		// It is now safe to access form data.s
+		ScoreTables::GetSingleton()->build(*Milf::GetSingleton());
 		EldenParry::GetSingleton()->init();
-		animEventHandler::Register(true, Settings::bEnableNPCParry);
+		NPCParryAI::GetSingleton()->init();
+		blockSpark::preloadSparkModels();
+		animEventHandler::Register(true, Settings::get().bEnableNPCParry);
+		actorEventHandler::Register();
 		break;
 
 		// Skyrim game events.
 	case SKSE::MessagingInterface::kNewGame:  // Player starts a new game from main menu.
 	case SKSE::MessagingInterface::kPreLoadGame:  // Player selected a game to load, but it hasn't loaded yet.
 		// Data will be the name of the loaded save.
+		EldenParry::GetSingleton()->purgeAll();
+		Hitstop::GetSingleton()->reset();
+		NPCParryAI::GetSingleton()->reset();
+		break;
 	case SKSE::MessagingInterface::kPostLoadGame:  // Player's selected save game has finished loading.
 		// Data will be a boolean indicating whether the load was successful.
+		if (Settings::get().bRunBenchmark && a_msg->data) {
+			ParryBenchmark::run();
+		}
+		break;
 	case SKSE::MessagingInterface::kSaveGame:      // The player has saved a game.
 		// Data will be the save name.
+		Hooks::ProjectileCollision::logContactStats();
+		LatencyStats::GetSingleton()->dump();
+		break;
 	case SKSE::MessagingInterface::kDeleteGame:  // The player deleted a saved game from within the load menu.
 		break;
 	}
@@ -35,10 +57,17 @@ void MessageHandler(SKSE::MessagingInterface::Message* a_msg)
 
 void Load()
 {
+	HotLog::GetSingleton()->start();
 	SKSE::GetMessagingInterface()->RegisterListener("SKSE", MessageHandler);
 
 	//Do stuff when SKSE initializes here:
-	Settings::readSettings();
+	Settings::Config config;
+	if (!SettingsSnapshot::load(config)) {
+		config = Settings::load();
+		SettingsSnapshot::save(config);
+	}
+	Settings::publish(config);
+	LatencyStats::GetSingleton()->start();
 	Hooks::install();
 }
 